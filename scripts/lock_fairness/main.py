@@ -0,0 +1,72 @@
+import csv
+import sys
+from collections import defaultdict
+
+import matplotlib.pyplot as plt
+
+
+def load_results(path):
+    """
+    Load the CSV written by src/cpp/multithreading/lock_benchmark.cpp.
+
+    Parameters:
+    - path: Path to lock_benchmark.csv
+
+    Returns:
+    - List of dicts, one per (lock, threads, cs_work, noncs_work) run
+    """
+    with open(path, newline="") as f:
+        rows = list(csv.DictReader(f))
+    for row in rows:
+        for key in ("threads", "cs_work", "noncs_work"):
+            row[key] = int(row[key])
+        for key in ("throughput_per_sec", "p99_ns", "fairness"):
+            row[key] = float(row[key])
+    return rows
+
+
+def series_by_lock(rows, cs_work, noncs_work, metric):
+    """
+    Group one metric by lock type for a fixed workload shape.
+
+    Returns:
+    - Dict lock name -> (thread counts, metric values), sorted by thread count
+    """
+    series = defaultdict(list)
+    for row in rows:
+        if row["cs_work"] == cs_work and row["noncs_work"] == noncs_work:
+            series[row["lock"]].append((row["threads"], row[metric]))
+    return {lock: tuple(zip(*sorted(points))) for lock, points in series.items()}
+
+
+# Usage: python main.py [lock_benchmark.csv] [cs_work] [noncs_work]
+path = sys.argv[1] if len(sys.argv) > 1 else "lock_benchmark.csv"
+cs_work = int(sys.argv[2]) if len(sys.argv) > 2 else 50
+noncs_work = int(sys.argv[3]) if len(sys.argv) > 3 else 500
+
+rows = load_results(path)
+
+metrics = [
+    ("throughput_per_sec", "Acquisitions / second", "Throughput", "log"),
+    ("p99_ns", "p99 acquire latency (ns)", "Tail Acquire Latency", "log"),
+    ("fairness", "Jain's fairness index", "Fairness", "linear"),
+]
+
+fig, axes = plt.subplots(1, 3, figsize=(18, 6))
+
+for ax, (metric, ylabel, title, yscale) in zip(axes, metrics):
+    for lock, (threads, values) in series_by_lock(rows, cs_work, noncs_work, metric).items():
+        ax.plot(threads, values, marker="o", linewidth=2, label=lock)
+    ax.set_xscale("log", base=2)
+    ax.set_yscale(yscale)
+    ax.set_xlabel("Threads")
+    ax.set_ylabel(ylabel)
+    ax.set_title(f"{title} (cs={cs_work}, non-cs={noncs_work})")
+    ax.grid(True, which="both", ls="--", alpha=0.7)
+
+axes[2].set_ylim(0, 1.05)
+axes[2].axhline(y=1.0, color="k", linestyle="--", linewidth=1)
+axes[0].legend(title="Lock", fontsize="small")
+
+plt.tight_layout()
+plt.show()
@@ -0,0 +1,288 @@
+/**
+ * Cooperative Cancellation for Pool Tasks
+ *
+ * demo_timeout_no_cancel (future_timed_wait.cpp) shows that giving up on a
+ * future does not stop its task: it keeps burning CPU until it finishes on
+ * its own. For speculative work (try N strategies, keep the first answer)
+ * every abandoned branch wastes a whole core for its full run time.
+ *
+ * This pool threads std::stop_token (as in jthread.cpp) through submissions:
+ * - submit(token, f, args...): if f accepts a std::stop_token as its first
+ *   parameter it receives `token`, just like a jthread body; long-running
+ *   tasks poll stop_requested() and return early
+ * - CancelGroup owns a std::stop_source; tasks submitted with
+ *   group.token() form a group, and group.cancel() stops all of them:
+ *   running ones see the request at their next check, queued ones never start
+ * - dequeue-time dropping: a worker that pops an already-cancelled task
+ *   does not run it; its future throws TaskCancelled instead
+ *
+ * The benchmark is a first-result-wins search: 32 branches of CPU-bound work
+ * on a small pool, one of which finds the answer. It measures the CPU-seconds
+ * burned after the answer is known, with and without cancellation.
+ *
+ * Compile: g++ -std=c++20 -pthread -O2 cancellable_pool.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+struct TaskCancelled : std::runtime_error {
+    TaskCancelled() : std::runtime_error("task cancelled before it started") {}
+};
+
+// A set of tasks that are cancelled together.
+class CancelGroup {
+public:
+    std::stop_token token() const { return source_.get_token(); }
+    void cancel() { source_.request_stop(); }
+    bool cancelled() const { return source_.stop_requested(); }
+
+private:
+    std::stop_source source_;
+};
+
+// ─── ThreadPool with stop tokens ─────────────────────────────────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t num_threads) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(std::stop_token token, F&& f, Args&&... args) {
+        constexpr bool wants_token = std::is_invocable_v<F, std::stop_token, Args...>;
+        using ReturnType = typename std::conditional_t<wants_token,
+                                                       std::invoke_result<F, std::stop_token, Args...>,
+                                                       std::invoke_result<F, Args...>>::type;
+
+        auto promise = std::make_shared<std::promise<ReturnType>>();
+        std::future<ReturnType> result = promise->get_future();
+
+        Job job;
+        job.token = token;
+        job.run = [promise, token,
+                   func = std::forward<F>(f),
+                   targs = std::make_tuple(std::forward<Args>(args)...)](bool cancelled) mutable {
+            if (cancelled) {
+                promise->set_exception(std::make_exception_ptr(TaskCancelled{}));
+                return;
+            }
+            try {
+                auto call = [&] {
+                    if constexpr (wants_token) {
+                        return std::apply(func, std::tuple_cat(std::make_tuple(token), std::move(targs)));
+                    } else {
+                        return std::apply(func, std::move(targs));
+                    }
+                };
+                if constexpr (std::is_void_v<ReturnType>) {
+                    call();
+                    promise->set_value();
+                } else {
+                    promise->set_value(call());
+                }
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        };
+
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_)
+                throw std::runtime_error("submit() called on a stopped ThreadPool");
+            queue_.push(std::move(job));
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+    // Not cancellable: the token can never be stopped.
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) {
+        return submit(std::stop_token{}, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    std::size_t dropped() const { return dropped_.load(); }
+
+private:
+    struct Job {
+        std::stop_token token;
+        std::function<void(bool cancelled)> run;
+    };
+
+    void worker_loop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+                if (shutdown_ && queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop();
+            }
+            // Dequeue-time check: cancelled work is never started.
+            bool cancelled = job.token.stop_requested();
+            if (cancelled) dropped_.fetch_add(1, std::memory_order_relaxed);
+            job.run(cancelled);
+        }
+    }
+
+    std::vector<std::thread>   workers_;
+    std::queue<Job>            queue_;
+    std::mutex                 mutex_;
+    std::condition_variable    cv_;
+    bool                       shutdown_{false};
+    std::atomic<std::size_t>   dropped_{0};
+};
+
+// ─── Demo: timeout with cancellation ─────────────────────────────────────────
+
+void demo_timeout_with_cancel() {
+    std::cout << "=== timeout + cancellation (cf. demo_timeout_no_cancel) ===\n";
+    ThreadPool pool(1);  // one worker, so the siblings wait in the queue
+    CancelGroup group;
+    std::atomic<int> steps{0};
+
+    auto fut = pool.submit(group.token(), [&steps](std::stop_token st) {
+        for (int i = 0; i < 60; ++i) {  // 600 ms of work in 10 ms steps
+            if (st.stop_requested()) return -1;
+            std::this_thread::sleep_for(10ms);
+            ++steps;
+        }
+        return 0;
+    });
+    auto queued = pool.submit(group.token(), [] { return 1; });
+    auto queued2 = pool.submit(group.token(), [] { return 2; });
+
+    auto status = fut.wait_for(200ms);
+    std::cout << "  wait_for returned: "
+              << (status == std::future_status::timeout ? "timeout" : "ready") << "\n";
+    group.cancel();
+    std::cout << "  task returned " << fut.get() << " after " << steps.load() << " of 60 steps\n";
+    for (auto* f : {&queued, &queued2}) {
+        try {
+            f->get();
+            std::cout << "  queued sibling ran (it was dequeued before cancel)\n";
+        } catch (const TaskCancelled& e) {
+            std::cout << "  queued sibling: " << e.what() << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+// ─── Benchmark: first-result-wins search ─────────────────────────────────────
+
+double process_cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void burn_slice() {  // ~0.5 ms of CPU
+    volatile unsigned x = 1;
+    for (int i = 0; i < 400'000; ++i) x = x * 1664525u + 1013904223u;
+}
+
+struct SearchResult {
+    double answer_ms;
+    double drained_ms;
+    double wasted_cpu_s;
+    std::size_t dropped;
+};
+
+SearchResult search(bool cancel, std::size_t threads) {
+    constexpr int kBranches = 32;
+    ThreadPool pool(threads);
+    CancelGroup group;
+
+    // Branch lengths 20-200 slices; the answer is at slice 30 of branch 5.
+    std::mt19937 rng(1);
+    std::vector<int> lengths(kBranches);
+    for (int& l : lengths) l = 20 + static_cast<int>(rng() % 181);
+    constexpr int kWinner = 5, kWinningSlice = 30;
+    lengths[kWinner] = 200;
+
+    std::promise<int> answer;
+    std::atomic<bool> answered{false};
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<void>> branches;
+    for (int b = 0; b < kBranches; ++b) {
+        branches.push_back(pool.submit(group.token(), [&, b](std::stop_token st) {
+            for (int slice = 0; slice < lengths[b]; ++slice) {
+                if (cancel && st.stop_requested()) return;
+                burn_slice();
+                if (b == kWinner && slice == kWinningSlice && !answered.exchange(true)) {
+                    answer.set_value(b);
+                    if (cancel) group.cancel();
+                }
+            }
+        }));
+    }
+
+    answer.get_future().get();
+    double cpu_at_answer = process_cpu_seconds();
+    double answer_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto& f : branches) {
+        try {
+            f.get();
+        } catch (const TaskCancelled&) {
+        }
+    }
+    double drained_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return {answer_ms, drained_ms, process_cpu_seconds() - cpu_at_answer, pool.dropped()};
+}
+
+int main() {
+    demo_timeout_with_cancel();
+
+    std::size_t threads = std::max(4u, std::thread::hardware_concurrency());
+    std::cout << "=== first-result-wins search: 32 branches, " << threads << " threads ===\n";
+    std::cout << std::setw(18) << "" << std::setw(12) << "answer ms" << std::setw(14) << "drained ms"
+              << std::setw(16) << "wasted CPU s" << std::setw(10) << "dropped\n";
+    for (bool cancel : {false, true}) {
+        SearchResult r = search(cancel, threads);
+        std::cout << std::setw(18) << (cancel ? "with cancel" : "no cancel") << std::fixed
+                  << std::setprecision(1) << std::setw(12) << r.answer_ms << std::setw(14)
+                  << r.drained_ms << std::setprecision(3) << std::setw(16) << r.wasted_cpu_s
+                  << std::setw(9) << r.dropped << "\n";
+    }
+    std::cout << "\nWithout cancellation every branch runs to completion after the answer\n"
+              << "is known. With a CancelGroup, running branches stop within one slice\n"
+              << "and queued ones are dropped at dequeue.\n";
+    return 0;
+}
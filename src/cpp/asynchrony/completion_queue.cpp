@@ -0,0 +1,399 @@
+/**
+ * Completion Queue — Handle Pool Results in Finish Order
+ *
+ * demo_multiple_tasks (async_exception.cpp) and the main of
+ * thread_pool_futures.cpp collect results with a loop of get() calls in
+ * submission order. If task 0 is slow, every result that finished behind it
+ * sits unhandled until task 0 is done.
+ *
+ * A CompletionQueue turns that around:
+ * - submit(f, args...) runs f on the pool and returns a tag (0, 1, 2, ...)
+ * - when a task finishes, its outcome (value or exception) is pushed onto
+ *   the queue under its tag
+ * - pop() returns the next finished task, whichever it is; pop_batch()
+ *   takes everything that is ready (up to a limit) under one lock
+ * - Completion::get() returns the value or rethrows the task's exception,
+ *   the same semantics as std::future::get()
+ *
+ * Backpressure: the queue has a capacity of outstanding tasks (submitted
+ * but not yet popped). submit() blocks while it is full, so a fast producer
+ * can never pile up unbounded work or unconsumed results. Workers never
+ * block on the queue.
+ *
+ * Submitted tasks refer back to the queue, so its destructor waits for
+ * every task still running; completions nobody popped are dropped.
+ *
+ * Compile:
+ *   g++ -std=c++17 -pthread -O2 completion_queue.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// ─── ThreadPool (thread_pool_futures.cpp) ────────────────────────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t num_threads) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    void enqueue(std::function<void()> job) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_)
+                throw std::runtime_error("enqueue() called on a stopped ThreadPool");
+            queue_.push(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+        std::future<ReturnType> result = task->get_future();
+        enqueue([task] { (*task)(); });
+        return result;
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+                if (shutdown_ && queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread>          workers_;
+    std::queue<std::function<void()>> queue_;
+    std::mutex                        mutex_;
+    std::condition_variable           cv_;
+    bool                              shutdown_{false};
+};
+
+// ─── CompletionQueue ─────────────────────────────────────────────────────────
+
+// Outcome of one submitted task.
+template <typename T>
+class Completion {
+public:
+    Completion(std::size_t tag, std::optional<T> value, std::exception_ptr error)
+        : tag_(tag), value_(std::move(value)), error_(std::move(error)) {}
+
+    std::size_t tag() const { return tag_; }
+    bool has_error() const { return error_ != nullptr; }
+
+    // Value, or the task's exception rethrown.
+    T get() {
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
+    }
+
+private:
+    std::size_t tag_;
+    std::optional<T> value_;
+    std::exception_ptr error_;
+};
+
+// T must not be void; use a placeholder type for fire-and-forget tasks.
+template <typename T>
+class CompletionQueue {
+public:
+    CompletionQueue(ThreadPool& pool, std::size_t capacity) : pool_(pool), capacity_(capacity) {
+        if (capacity == 0) throw std::invalid_argument("CompletionQueue capacity must be > 0");
+    }
+
+    // Running tasks capture `this`: wait until each has posted its result.
+    ~CompletionQueue() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return done_.size() == outstanding_; });
+    }
+
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    // Blocks while `capacity` tasks are outstanding. Returns the task's tag.
+    template <typename F, typename... Args>
+    std::size_t submit(F&& f, Args&&... args) {
+        static_assert(std::is_convertible_v<std::invoke_result_t<F, Args...>, T>,
+                      "task result must convert to the queue's value type");
+        std::size_t tag;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [this] { return outstanding_ < capacity_; });
+            ++outstanding_;
+            tag = next_tag_++;
+        }
+
+        try {
+            pool_.enqueue([this, tag,
+                           func = std::forward<F>(f),
+                           targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                std::optional<T> value;
+                std::exception_ptr error;
+                try {
+                    value.emplace(std::apply(std::move(func), std::move(targs)));
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                // Notify under the lock: once it is released the queue may
+                // be destroyed.
+                std::scoped_lock lock(mutex_);
+                done_.emplace_back(tag, std::move(value), std::move(error));
+                not_empty_.notify_all();
+            });
+        } catch (...) {
+            // The task will never post a result: give its slot back.
+            {
+                std::scoped_lock lock(mutex_);
+                --outstanding_;
+            }
+            not_full_.notify_one();
+            not_empty_.notify_all();
+            throw;
+        }
+        return tag;
+    }
+
+    // Next finished task, waiting if none is ready yet. Returns nullopt only
+    // when nothing is outstanding, so a drain loop is `while (auto c = q.pop())`.
+    std::optional<Completion<T>> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !done_.empty() || outstanding_ == 0; });
+        if (done_.empty()) return std::nullopt;
+        Completion<T> c = std::move(done_.front());
+        done_.pop_front();
+        --outstanding_;
+        lock.unlock();
+        not_full_.notify_one();
+        return c;
+    }
+
+    std::optional<Completion<T>> try_pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (done_.empty()) return std::nullopt;
+        Completion<T> c = std::move(done_.front());
+        done_.pop_front();
+        --outstanding_;
+        lock.unlock();
+        not_full_.notify_one();
+        return c;
+    }
+
+    // Append up to max_count finished tasks to out, waiting for at least one
+    // if any are outstanding. Returns how many were appended.
+    std::size_t pop_batch(std::vector<Completion<T>>& out, std::size_t max_count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (max_count == 0) return 0;
+        not_empty_.wait(lock, [this] { return !done_.empty() || outstanding_ == 0; });
+        std::size_t n = std::min(max_count, done_.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            out.push_back(std::move(done_.front()));
+            done_.pop_front();
+        }
+        outstanding_ -= n;
+        lock.unlock();
+        not_full_.notify_all();
+        return n;
+    }
+
+    std::size_t outstanding() const {
+        std::scoped_lock lock(mutex_);
+        return outstanding_;
+    }
+
+private:
+    ThreadPool& pool_;
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<Completion<T>> done_;
+    std::size_t outstanding_ = 0;
+    std::size_t next_tag_ = 0;
+};
+
+// ─── Demo: async_exception.cpp's demo_multiple_tasks in finish order ─────────
+
+int risky_task(int id) {
+    // Later ids finish first, so submission order and finish order differ.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20 * (6 - id)));
+    if (id % 2 == 0) {
+        throw std::runtime_error("task " + std::to_string(id) + " failed");
+    }
+    return id * 10;
+}
+
+void demo_multiple_tasks() {
+    std::cout << "=== multiple tasks, handled in completion order ===\n";
+
+    ThreadPool pool(6);
+    CompletionQueue<int> results(pool, 16);
+    for (int i = 0; i < 6; ++i) {
+        results.submit(risky_task, i);
+    }
+
+    while (auto c = results.pop()) {
+        try {
+            int value = c->get();
+            std::cout << "  task " << c->tag() << " result = " << value << "\n";
+        } catch (const std::exception& e) {
+            std::cout << "  task " << c->tag() << " exception: " << e.what() << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+// ─── Demo: backpressure ──────────────────────────────────────────────────────
+
+void demo_backpressure() {
+    std::cout << "=== backpressure: capacity 4, 40 tasks ===\n";
+
+    ThreadPool pool(8);
+    CompletionQueue<int> results(pool, 4);
+    std::size_t max_outstanding = 0;
+
+    std::thread producer([&] {
+        for (int i = 0; i < 40; ++i) {
+            results.submit([i] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                return i;
+            });
+            max_outstanding = std::max(max_outstanding, results.outstanding());
+        }
+    });
+
+    int handled = 0;
+    std::vector<Completion<int>> batch;
+    while (handled < 40) {
+        batch.clear();
+        handled += static_cast<int>(results.pop_batch(batch, 8));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));  // slow consumer
+    }
+    producer.join();
+    std::cout << "  handled " << handled << " results; outstanding never exceeded "
+              << max_outstanding << "\n\n";
+}
+
+// ─── Benchmark: skewed durations ─────────────────────────────────────────────
+
+using Clock = std::chrono::steady_clock;
+
+int skewed_task(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    return ms;
+}
+
+struct Stats {
+    double mean_ms;
+    double p99_ms;
+    double total_ms;
+};
+
+Stats summarize(std::vector<double> latencies, double total_ms) {
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double l : latencies) sum += l;
+    return {sum / latencies.size(), latencies[latencies.size() * 99 / 100], total_ms};
+}
+
+// Latency = time from submit until the consumer has the result in hand.
+Stats in_order_get(const std::vector<int>& durations, std::size_t threads) {
+    ThreadPool pool(threads);
+    auto start = Clock::now();
+    std::vector<Clock::time_point> submitted;
+    std::vector<std::future<int>> futures;
+    for (int ms : durations) {
+        submitted.push_back(Clock::now());
+        futures.push_back(pool.submit(skewed_task, ms));
+    }
+    std::vector<double> latencies;
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+        futures[i].get();
+        latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - submitted[i]).count());
+    }
+    return summarize(latencies, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+}
+
+Stats completion_order(const std::vector<int>& durations, std::size_t threads) {
+    ThreadPool pool(threads);
+    CompletionQueue<int> results(pool, durations.size());
+    auto start = Clock::now();
+    std::vector<Clock::time_point> submitted;
+    for (int ms : durations) {
+        submitted.push_back(Clock::now());
+        results.submit(skewed_task, ms);
+    }
+    std::vector<double> latencies;
+    while (auto c = results.pop()) {
+        c->get();
+        latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - submitted[c->tag()]).count());
+    }
+    return summarize(latencies, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+}
+
+int main() {
+    demo_multiple_tasks();
+    demo_backpressure();
+
+    // 200 tasks on 8 threads: 95% take 1 ms, 5% take 100 ms.
+    std::vector<int> durations;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 200; ++i) durations.push_back(rng() % 20 == 0 ? 100 : 1);
+
+    Stats get_stats = in_order_get(durations, 8);
+    Stats cq_stats = completion_order(durations, 8);
+
+    std::cout << "=== 200 tasks, 5% slow (100 ms), 8 threads ===\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(22) << "" << std::setw(12) << "mean ms" << std::setw(12) << "p99 ms"
+              << std::setw(12) << "total ms\n";
+    std::cout << std::setw(22) << "in-order get()" << std::setw(12) << get_stats.mean_ms
+              << std::setw(12) << get_stats.p99_ms << std::setw(12) << get_stats.total_ms << "\n";
+    std::cout << std::setw(22) << "completion queue" << std::setw(12) << cq_stats.mean_ms
+              << std::setw(12) << cq_stats.p99_ms << std::setw(12) << cq_stats.total_ms << "\n";
+    std::cout << "\nTotal time is the same: the pool does the same work. What changes is\n"
+              << "how long each finished result waits before the consumer sees it.\n";
+    return 0;
+}
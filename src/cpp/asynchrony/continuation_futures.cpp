@@ -0,0 +1,402 @@
+/**
+ * Non-Blocking Continuations on Thread Pool Futures
+ *
+ * ThreadPool::submit (thread_pool_futures.cpp) returns a plain std::future.
+ * The only way to run stage B after stage A is for some thread to block in
+ * a.get(). Inside a pool that parks a worker per in-flight chain, and once
+ * every worker is parked the pool stops making progress altogether.
+ *
+ * PoolFuture<T> lets you describe "what happens next" instead of waiting:
+ *   - then(f)       returns a PoolFuture for f(value). When the value is
+ *                   ready, f is scheduled on the pool. Exceptions skip f and
+ *                   flow straight into the returned future.
+ *   - on_ready(cb)  calls cb(ready_future) once the result is available;
+ *                   cb can call get() without blocking and see errors.
+ *   - get()         still available for the final consumer.
+ *
+ * If the future is already complete when then()/on_ready() is called, the
+ * continuation runs inline on the calling thread: no queue round-trip.
+ *
+ * Ownership runs one way, from each link to the next: a state's callback
+ * list holds the next link's state, never its own. A continuation reaches
+ * the state that completed through its argument, and the queued job that
+ * runs it keeps that state alive. So there are no reference cycles.
+ *
+ * One caveat: a then() chain that never completes is torn down
+ * recursively. Dropping the head destroys its callbacks, which destroy
+ * the next state, and so on: one nested destructor per link. Chains of
+ * hundreds of thousands of pending links can overflow the stack that
+ * way. Complete the head (even with an error), or keep chains short.
+ *
+ * Continuations are posted to the pool. If the pool has begun shutting
+ * down, they run inline on the completing thread instead, so a task that
+ * finishes while ~ThreadPool drains the queue does not throw.
+ *
+ * The benchmark builds a 1M-link chain with then() and compares it with the
+ * blocking pattern, where each link is a pool task that calls get() on its
+ * predecessor.
+ *
+ * Compile:
+ *   g++ -std=c++17 -pthread -O2 continuation_futures.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+// ─── Shared state ────────────────────────────────────────────────────────────
+
+struct Unit {};  // stands in for void results
+
+template <typename T>
+using Stored = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+// Result type of a continuation: f(T), or f() for void predecessors.
+template <typename F, typename T>
+struct ContinuationResult { using type = std::invoke_result_t<F, T>; };
+
+template <typename F>
+struct ContinuationResult<F, void> { using type = std::invoke_result_t<F>; };
+
+template <typename T>
+class FutureState : public std::enable_shared_from_this<FutureState<T>> {
+public:
+    using Callback = std::function<void(FutureState&)>;
+
+    explicit FutureState(ThreadPool* pool) : pool_(pool) {}
+
+    void set_value(Stored<T> value) {
+        complete([&] { value_.emplace(std::move(value)); });
+    }
+
+    void set_error(std::exception_ptr error) {
+        complete([&] { error_ = std::move(error); });
+    }
+
+    // Runs cb on the pool once complete, or inline right now if already done.
+    void attach(Callback cb) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (!ready_) {
+                callbacks_.push_back(std::move(cb));
+                return;
+            }
+        }
+        cb(*this);
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return ready_; });
+    }
+
+    // Only valid once ready; consumes the value.
+    Stored<T> take() {
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
+    }
+
+    std::exception_ptr error() const { return error_; }
+    ThreadPool* pool() const { return pool_; }
+
+private:
+    template <typename Fill>
+    void complete(Fill fill);
+
+    ThreadPool* pool_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool ready_ = false;
+    std::optional<Stored<T>> value_;
+    std::exception_ptr error_;
+    std::vector<Callback> callbacks_;
+};
+
+// ─── PoolFuture ──────────────────────────────────────────────────────────────
+
+template <typename T>
+class PoolFuture {
+public:
+    PoolFuture() = default;
+    explicit PoolFuture(std::shared_ptr<FutureState<T>> state) : state_(std::move(state)) {}
+
+    bool valid() const { return state_ != nullptr; }
+
+    // Block until ready without consuming the result.
+    void wait() const { state_->wait(); }
+
+    T get() {
+        auto state = std::exchange(state_, nullptr);
+        state->wait();
+        if constexpr (std::is_void_v<T>) {
+            state->take();
+        } else {
+            return state->take();
+        }
+    }
+
+    // Schedule f(value) after this future completes. Consumes *this.
+    template <typename F, typename U = typename ContinuationResult<F, T>::type>
+    PoolFuture<U> then(F&& f) {
+        auto prev = std::exchange(state_, nullptr);
+        auto next = std::make_shared<FutureState<U>>(prev->pool());
+
+        prev->attach([next, func = std::forward<F>(f)](FutureState<T>& done) mutable {
+            if (auto error = done.error()) {
+                next->set_error(error);
+                return;
+            }
+            try {
+                if constexpr (std::is_void_v<T> && std::is_void_v<U>) {
+                    func();
+                    next->set_value(Unit{});
+                } else if constexpr (std::is_void_v<T>) {
+                    next->set_value(func());
+                } else if constexpr (std::is_void_v<U>) {
+                    func(std::move(done.take()));
+                    next->set_value(Unit{});
+                } else {
+                    next->set_value(func(std::move(done.take())));
+                }
+            } catch (...) {
+                next->set_error(std::current_exception());
+            }
+        });
+        return PoolFuture<U>(std::move(next));
+    }
+
+    // Call cb(ready_future) once complete. Consumes *this.
+    template <typename F>
+    void on_ready(F&& cb) {
+        auto prev = std::exchange(state_, nullptr);
+        // Take the state from the argument: capturing prev here would put
+        // prev in its own callback list.
+        prev->attach([callback = std::forward<F>(cb)](FutureState<T>& done) mutable {
+            callback(PoolFuture<T>(done.shared_from_this()));
+        });
+    }
+
+private:
+    std::shared_ptr<FutureState<T>> state_;
+};
+
+// ─── ThreadPool (thread_pool_futures.cpp) returning PoolFuture ───────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t num_threads) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    void enqueue(std::function<void()> job) {
+        if (!try_enqueue(job))
+            throw std::runtime_error("enqueue() called on a stopped ThreadPool");
+    }
+
+    // Like enqueue(), but returns false (leaving job untouched) once the
+    // pool is shutting down.
+    bool try_enqueue(std::function<void()>& job) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_) return false;
+            queue_.push(std::move(job));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> PoolFuture<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto state = std::make_shared<FutureState<ReturnType>>(this);
+        enqueue([state,
+                 func = std::forward<F>(f),
+                 targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            try {
+                if constexpr (std::is_void_v<ReturnType>) {
+                    std::apply(std::move(func), std::move(targs));
+                    state->set_value(Unit{});
+                } else {
+                    state->set_value(std::apply(std::move(func), std::move(targs)));
+                }
+            } catch (...) {
+                state->set_error(std::current_exception());
+            }
+        });
+        return PoolFuture<ReturnType>(std::move(state));
+    }
+
+    std::size_t thread_count() const { return workers_.size(); }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+                if (shutdown_ && queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread>          workers_;
+    std::queue<std::function<void()>> queue_;
+    std::mutex                        mutex_;
+    std::condition_variable           cv_;
+    bool                              shutdown_{false};
+};
+
+template <typename T>
+template <typename Fill>
+void FutureState<T>::complete(Fill fill) {
+    std::vector<Callback> callbacks;
+    {
+        std::scoped_lock lock(mutex_);
+        fill();
+        ready_ = true;
+        callbacks.swap(callbacks_);
+    }
+    cv_.notify_all();
+
+    // Each queued continuation keeps this state alive until it has run.
+    // Once the pool is stopping, run continuations inline instead.
+    for (auto& cb : callbacks) {
+        std::function<void()> job = [self = this->shared_from_this(), cb = std::move(cb)] { cb(*self); };
+        if (!pool_->try_enqueue(job)) job();
+    }
+}
+
+// ── Benchmark ──────────────────────────────────────────────────────────────
+
+constexpr int kThreads = 4;
+constexpr int kChainLength = 1'000'000;
+
+double continuation_chain_ms(long& result) {
+    ThreadPool pool(kThreads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Hold the root back until the chain is built, so every link really is
+    // scheduled on the pool instead of running inline on this thread.
+    std::promise<void> gate;
+    auto opened = gate.get_future().share();
+    PoolFuture<long> f = pool.submit([opened] { opened.wait(); return 0L; });
+    for (int i = 0; i < kChainLength; ++i) {
+        f = f.then([](long x) { return x + 1; });
+    }
+    gate.set_value();
+    result = f.get();
+
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Blocking pattern: each link is a pool task that waits for the previous one.
+double blocking_chain_ms(long& result) {
+    ThreadPool pool(kThreads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::shared_future<long>> links;
+    links.reserve(kChainLength + 1);
+    std::promise<long> root;
+    links.push_back(root.get_future().share());
+    for (int i = 0; i < kChainLength; ++i) {
+        auto p = std::make_shared<std::promise<long>>();
+        links.push_back(p->get_future().share());
+        pool.enqueue([p, prev = links[i]] { p->set_value(prev.get() + 1); });
+    }
+    root.set_value(0);
+    result = links.back().get();
+
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main() {
+    // ── then / on_ready basics ────────────────────────────────────────
+    {
+        ThreadPool pool(2);
+        auto parsed = pool.submit([] { return std::string("21"); })
+                          .then([](std::string s) { return std::stoi(s); })
+                          .then([](int x) { return x * 2; });
+        std::cout << "then chain: " << parsed.get() << "\n";
+
+        std::promise<void> done;
+        pool.submit([]() -> int { throw std::runtime_error("stage A failed"); })
+            .then([](int x) { return x + 1; })  // skipped
+            .on_ready([&done](PoolFuture<int> f) {
+                try {
+                    f.get();
+                } catch (const std::exception& e) {
+                    std::cout << "on_ready saw error: " << e.what() << "\n";
+                }
+                done.set_value();
+            });
+        done.get_future().wait();
+
+        // Already complete: the continuation runs inline on this thread.
+        auto early = pool.submit([] { return 1; });
+        early.wait();
+        auto ran_on = early.then([](int) { return std::this_thread::get_id(); });
+        std::cout << "continuation on a completed future ran inline: " << std::boolalpha
+                  << (ran_on.get() == std::this_thread::get_id()) << "\n";
+    }
+    {
+        // The task completes while ~ThreadPool drains the queue: its
+        // continuation can no longer be posted, so it runs inline.
+        std::atomic<bool> ran{false};
+        {
+            ThreadPool pool(1);
+            pool.submit([] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return 1;
+            }).then([&ran](int) { ran = true; });
+        }
+        std::cout << "continuation during pool shutdown ran: " << ran.load() << "\n\n";
+    }
+
+    // ── 1M-link chain ─────────────────────────────────────────────────
+    long cont_result = 0, block_result = 0;
+    double cont_ms = continuation_chain_ms(cont_result);
+    double block_ms = blocking_chain_ms(block_result);
+
+    std::cout << "=== " << kChainLength << "-link chain, " << kThreads << " workers ===\n";
+    std::cout << "  then() continuations: " << cont_ms << " ms (result " << cont_result << ")\n";
+    std::cout << "  blocking get():       " << block_ms << " ms (result " << block_result << ")\n";
+    if (cont_ms > 0) std::cout << "  Speedup: " << block_ms / cont_ms << "x\n";
+    std::cout << "\nWith get(), up to " << kThreads << " workers sit blocked on their\n"
+              << "predecessor at any moment; with then(), no worker ever waits.\n";
+    return 0;
+}
@@ -0,0 +1,577 @@
+/**
+ * Allocation-Free Tasks for a Thread Pool
+ *
+ * The pools in thread_pool.cpp and thread_pool_futures.cpp pay for every
+ * task on the heap:
+ *   - std::function<void()> allocates when the lambda does not fit its
+ *     (implementation-defined, often 16-byte) small buffer
+ *   - submit() adds std::make_shared<std::packaged_task>, whose shared
+ *     state is a second allocation, plus the std::function wrapper
+ *   - std::queue (a std::deque) allocates new chunks as it grows
+ *
+ * This example replaces all of them:
+ *   - InplaceTask: a move-only, type-erased void() callable that stores
+ *     small callables inline. The whole object is one cache line.
+ *   - TaskBlock: for submit(), the callable and its result slot live in the
+ *     same block. Blocks come from a free list owned by the pool, so in the
+ *     steady state no block is allocated at all.
+ *   - The work queue is a ring buffer of InplaceTask that only allocates
+ *     when it has to grow.
+ *
+ * Both the enqueue() interface of thread_pool.cpp and the submit() interface
+ * of thread_pool_futures.cpp are provided on top of InplaceTask.
+ *
+ * The benchmark replaces the global operator new with a counting version and
+ * reports heap allocations per task for the old and new pools.
+ *
+ * Note: a Future must not outlive the pool that produced it, because its
+ * block is returned to that pool's free list.
+ *
+ * Compile:
+ *   g++ -std=c++20 -pthread -O2 inplace_task_pool.cpp
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ─── Allocation counter ──────────────────────────────────────────────────────
+
+std::atomic<long> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// ─── InplaceTask: move-only void() callable with inline storage ──────────────
+
+class InplaceTask {
+public:
+    // Inline buffer plus the ops pointer fill exactly one 64-byte cache line.
+    static constexpr std::size_t kInlineSize = 64 - sizeof(void*);
+
+    template <typename F>
+    static constexpr bool fits_inline =
+        sizeof(F) <= kInlineSize &&
+        alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<F>;
+
+    InplaceTask() noexcept = default;
+
+    template <typename F, typename D = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<D, InplaceTask>>>
+    InplaceTask(F&& f) {
+        if constexpr (fits_inline<D>) {
+            ::new (static_cast<void*>(storage_)) D(std::forward<F>(f));
+            ops_ = &kInlineOps<D>;
+        } else {
+            // Large callables fall back to the heap, like std::function.
+            D* heap = new D(std::forward<F>(f));
+            ::new (static_cast<void*>(storage_)) D*(heap);
+            ops_ = &kHeapOps<D>;
+        }
+    }
+
+    InplaceTask(InplaceTask&& other) noexcept { take(other); }
+
+    InplaceTask& operator=(InplaceTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    InplaceTask(const InplaceTask&) = delete;
+    InplaceTask& operator=(const InplaceTask&) = delete;
+
+    ~InplaceTask() { reset(); }
+
+    void operator()() { ops_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+private:
+    struct Ops {
+        void (*invoke)(void* self);
+        void (*relocate)(void* from, void* to) noexcept;  // move + destroy source
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template <typename D>
+    static constexpr Ops kInlineOps{
+        [](void* self) { (*static_cast<D*>(self))(); },
+        [](void* from, void* to) noexcept {
+            ::new (to) D(std::move(*static_cast<D*>(from)));
+            static_cast<D*>(from)->~D();
+        },
+        [](void* self) noexcept { static_cast<D*>(self)->~D(); },
+    };
+
+    template <typename D>
+    static constexpr Ops kHeapOps{
+        [](void* self) { (**static_cast<D**>(self))(); },
+        [](void* from, void* to) noexcept {
+            ::new (to) D*(*static_cast<D**>(from));
+        },
+        [](void* self) noexcept { delete *static_cast<D**>(self); },
+    };
+
+    void take(InplaceTask& other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(other.storage_, storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+static_assert(sizeof(InplaceTask) == 64, "InplaceTask should be one cache line");
+
+// ─── TaskBlock: callable and result slot in one block ────────────────────────
+
+class InplacePool;
+
+struct BlockHeader {
+    enum State : int { kPending = 0, kReady = 1 };
+
+    void (*run)(BlockHeader* self);
+    void (*destroy)(BlockHeader* self) noexcept;  // destroys callable/result
+    InplacePool* pool;
+    bool from_free_list;
+    std::atomic<int> refs{2};  // one for the queued task, one for the Future
+    std::atomic<int> state{kPending};
+    std::exception_ptr error;
+    void* result = nullptr;  // points into the concrete block's result slot
+};
+
+// Every pooled block has this size; bigger blocks go straight to the heap.
+constexpr std::size_t kBlockSize = 256;
+
+template <typename F, typename R>
+struct TaskBlock : BlockHeader {
+    explicit TaskBlock(F&& f) : fn(std::move(f)) { result = storage; }
+
+    F fn;
+    alignas(R) unsigned char storage[sizeof(R)];
+};
+
+template <typename F>
+struct TaskBlock<F, void> : BlockHeader {
+    explicit TaskBlock(F&& f) : fn(std::move(f)) {}
+
+    F fn;
+};
+
+void release_block(BlockHeader* block) noexcept;
+
+template <typename R>
+class Future {
+public:
+    Future() = default;
+    explicit Future(BlockHeader* block) : block_(block) {}
+
+    Future(Future&& other) noexcept : block_(std::exchange(other.block_, nullptr)) {}
+    Future& operator=(Future&& other) noexcept {
+        if (this != &other) {
+            if (block_) release_block(block_);
+            block_ = std::exchange(other.block_, nullptr);
+        }
+        return *this;
+    }
+
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    ~Future() {
+        if (block_) release_block(block_);
+    }
+
+    void wait() const {
+        // C++20 atomic wait: futex on Linux, no mutex/condvar pair needed.
+        block_->state.wait(BlockHeader::kPending, std::memory_order_acquire);
+    }
+
+    R get() {
+        wait();
+        BlockHeader* block = std::exchange(block_, nullptr);
+        struct Release {
+            BlockHeader* b;
+            ~Release() { release_block(b); }
+        } guard{block};
+
+        if (block->error) std::rethrow_exception(block->error);
+        if constexpr (!std::is_void_v<R>) {
+            return std::move(*static_cast<R*>(block->result));
+        }
+    }
+
+private:
+    BlockHeader* block_ = nullptr;
+};
+
+// ─── InplacePool ─────────────────────────────────────────────────────────────
+
+class InplacePool {
+public:
+    explicit InplacePool(std::size_t num_threads, std::size_t initial_capacity = 1024)
+        : ring_(initial_capacity) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~InplacePool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+        for (void* p : free_blocks_) ::operator delete(p);
+    }
+
+    InplacePool(const InplacePool&) = delete;
+    InplacePool& operator=(const InplacePool&) = delete;
+
+    // Fire-and-forget, as in thread_pool.cpp.
+    template <typename F>
+    void enqueue(F&& f) {
+        InplaceTask task(std::forward<F>(f));
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_)
+                throw std::runtime_error("enqueue() called on a stopped InplacePool");
+            push_locked(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    // Future-returning, as in thread_pool_futures.cpp.
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> Future<std::invoke_result_t<F, Args...>> {
+        using R = std::invoke_result_t<F, Args...>;
+        auto bound = [func = std::forward<F>(f),
+                      targs = std::make_tuple(std::forward<Args>(args)...)]() mutable -> R {
+            return std::apply(std::move(func), std::move(targs));
+        };
+        using Fn = decltype(bound);
+        using Block = TaskBlock<Fn, R>;
+        constexpr bool pooled = sizeof(Block) <= kBlockSize &&
+                                alignof(Block) <= alignof(std::max_align_t);
+
+        Future<R> fut;
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_)
+                throw std::runtime_error("submit() called on a stopped InplacePool");
+
+            void* mem = pooled ? take_free_block_locked() : ::operator new(sizeof(Block));
+            auto* block = ::new (mem) Block(std::move(bound));
+            block->pool = this;
+            block->from_free_list = pooled;
+            block->run = [](BlockHeader* self) {
+                auto* b = static_cast<Block*>(self);
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        b->fn();
+                    } else {
+                        ::new (b->result) R(b->fn());
+                    }
+                } catch (...) {
+                    b->error = std::current_exception();
+                }
+                b->state.store(BlockHeader::kReady, std::memory_order_release);
+                b->state.notify_all();
+            };
+            block->destroy = [](BlockHeader* self) noexcept {
+                auto* b = static_cast<Block*>(self);
+                if constexpr (!std::is_void_v<R>) {
+                    if (b->state.load(std::memory_order_relaxed) == BlockHeader::kReady &&
+                        !b->error) {
+                        static_cast<R*>(b->result)->~R();
+                    }
+                }
+                b->~Block();
+            };
+
+            // The queued task is just a pointer: always fits inline.
+            push_locked(InplaceTask([block] {
+                block->run(block);
+                release_block(block);
+            }));
+            fut = Future<R>(block);
+        }
+        cv_.notify_one();
+        return fut;
+    }
+
+    std::size_t thread_count() const { return workers_.size(); }
+
+    void recycle(BlockHeader* block) noexcept {
+        bool pooled = block->from_free_list;
+        block->destroy(block);
+        if (pooled) {
+            std::scoped_lock lock(mutex_);
+            free_blocks_.push_back(block);
+        } else {
+            ::operator delete(block);
+        }
+    }
+
+private:
+    void* take_free_block_locked() {
+        if (free_blocks_.empty()) return ::operator new(kBlockSize);
+        void* p = free_blocks_.back();
+        free_blocks_.pop_back();
+        return p;
+    }
+
+    void push_locked(InplaceTask&& task) {
+        if (count_ == ring_.size()) grow_locked();
+        ring_[(head_ + count_) % ring_.size()] = std::move(task);
+        ++count_;
+    }
+
+    void grow_locked() {
+        std::vector<InplaceTask> bigger(ring_.size() * 2);
+        for (std::size_t i = 0; i < count_; ++i) {
+            bigger[i] = std::move(ring_[(head_ + i) % ring_.size()]);
+        }
+        ring_ = std::move(bigger);
+        head_ = 0;
+    }
+
+    void worker_loop() {
+        while (true) {
+            InplaceTask job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || count_ > 0; });
+                if (shutdown_ && count_ == 0) return;
+                job = std::move(ring_[head_]);
+                head_ = (head_ + 1) % ring_.size();
+                --count_;
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread>  workers_;
+    std::vector<InplaceTask>  ring_;
+    std::size_t               head_ = 0;
+    std::size_t               count_ = 0;
+    std::vector<void*>        free_blocks_;
+    std::mutex                mutex_;
+    std::condition_variable   cv_;
+    bool                      shutdown_{false};
+};
+
+void release_block(BlockHeader* block) noexcept {
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block->pool->recycle(block);
+    }
+}
+
+// ─── Baseline: the pool from thread_pool_futures.cpp ─────────────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t num_threads) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::scoped_lock lock(mutex_);
+            queue_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+
+        std::future<ReturnType> fut = task->get_future();
+
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_)
+                throw std::runtime_error("submit() called on a stopped ThreadPool");
+            queue_.push([task]() { (*task)(); });
+        }
+        cv_.notify_one();
+
+        return fut;
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+                if (shutdown_ && queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread>          workers_;
+    std::queue<std::function<void()>> queue_;
+    std::mutex                        mutex_;
+    std::condition_variable           cv_;
+    bool                              shutdown_{false};
+};
+
+// ── Benchmark ──────────────────────────────────────────────────────────────
+
+constexpr int kThreads = 4;
+constexpr int kTasks   = 200'000;
+constexpr int kBatch   = 256;  // tasks in flight at once
+
+volatile long g_sink;  // keeps results observable to the optimizer
+
+struct Result {
+    double allocs_per_task;
+    double ns_per_task;
+};
+
+template <typename Body>
+Result measure(Body&& body) {
+    body();  // warm-up: grows queues and fills free lists
+    long before = g_allocations.load();
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    long allocs = g_allocations.load() - before;
+    return {static_cast<double>(allocs) / kTasks,
+            std::chrono::duration<double, std::nano>(elapsed).count() / kTasks};
+}
+
+template <typename Pool>
+Result bench_enqueue(Pool& pool) {
+    return measure([&] {
+        std::atomic<int> done{0};
+        std::array<long, 4> payload{1, 2, 3, 4};  // 32-byte capture
+        for (int i = 0; i < kTasks; ++i) {
+            pool.enqueue([&done, payload, i] {
+                if (payload[i & 3] >= 0) done.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        while (done.load() < kTasks) std::this_thread::yield();
+    });
+}
+
+template <typename Pool, typename FutureVec>
+Result bench_submit(Pool& pool, FutureVec& futures) {
+    return measure([&] {
+        long sum = 0;
+        for (int i = 0; i < kTasks; i += kBatch) {
+            futures.clear();
+            for (int j = 0; j < kBatch; ++j) {
+                futures.push_back(pool.submit([](int x) { return x * 2; }, i + j));
+            }
+            for (auto& f : futures) sum += f.get();
+        }
+        g_sink = sum;
+    });
+}
+
+void print_row(const char* name, Result r) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2) << r.allocs_per_task
+              << std::setw(12) << std::setprecision(0) << r.ns_per_task << "\n";
+}
+
+int main() {
+    std::cout << "=== " << kTasks << " tasks, " << kThreads << " workers ===\n\n";
+    std::cout << "  " << std::left << std::setw(34) << "pool / call" << std::right
+              << std::setw(10) << "allocs" << std::setw(12) << "ns/task" << "\n";
+
+    Result old_enqueue, old_submit, new_enqueue, new_submit;
+    {
+        ThreadPool pool(kThreads);
+        std::vector<std::future<int>> futures;
+        futures.reserve(kBatch);
+        old_enqueue = bench_enqueue(pool);
+        old_submit  = bench_submit(pool, futures);
+    }
+    {
+        InplacePool pool(kThreads);
+        std::vector<Future<int>> futures;
+        futures.reserve(kBatch);
+        new_enqueue = bench_enqueue(pool);
+        new_submit  = bench_submit(pool, futures);
+    }
+
+    print_row("ThreadPool::enqueue (std::function)", old_enqueue);
+    print_row("InplacePool::enqueue", new_enqueue);
+    print_row("ThreadPool::submit (packaged_task)", old_submit);
+    print_row("InplacePool::submit", new_submit);
+
+    // ── Exception propagation still works ─────────────────────────────
+    {
+        InplacePool pool(2);
+        auto bad = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+        try {
+            bad.get();
+        } catch (const std::exception& e) {
+            std::cout << "\nCaught from InplacePool task: " << e.what() << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+/**
+ * pooled_async — Drop-in Pooled Replacement for std::async(std::launch::async)
+ *
+ * basic_async.cpp, parallel_futures.cpp, shared_future.cpp and the rest of
+ * this directory launch work with std::async(std::launch::async, ...). On
+ * libstdc++ every such call creates an OS thread and destroys it when the
+ * task finishes: tens of microseconds of overhead for each call.
+ *
+ * pooled_async(f, args...) keeps the same contract:
+ * - f and args are decay-copied, exactly as std::async does
+ * - returns std::future<R>; get() returns the value or rethrows f's exception
+ * - the task is guaranteed to start without waiting for other pooled_async
+ *   tasks, so code that blocks on one future from inside another keeps
+ *   working (as it does with one thread per call)
+ * but runs on a global pool that starts on first use:
+ * - hardware_concurrency() core threads, reused across calls
+ * - if every thread is busy when a call arrives, an extra thread is started;
+ *   extras retire after 1 s idle, so bursts and blocking chains cannot
+ *   deadlock or queue behind each other
+ *
+ * One intentional difference: a std::async future's destructor blocks until
+ * the task completes; a pooled_async future's does not (like a future from
+ * std::promise or a thread pool).
+ *
+ * The benchmark compares std::thread, std::async and pooled_async on calls
+ * per second and on start latency (call site to first line of the task).
+ *
+ * Compile:
+ *   g++ -std=c++17 -pthread -O2 pooled_async.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// ─── Global async pool ───────────────────────────────────────────────────────
+
+class AsyncPool {
+public:
+    explicit AsyncPool(std::size_t core_threads) : core_threads_(core_threads) {
+        std::scoped_lock lock(mutex_);
+        for (std::size_t i = 0; i < core_threads; ++i) spawn_locked();
+    }
+
+    ~AsyncPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    AsyncPool(const AsyncPool&) = delete;
+    AsyncPool& operator=(const AsyncPool&) = delete;
+
+    void enqueue(std::function<void()> job) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (stop_) throw std::runtime_error("pooled_async() called during shutdown");
+            jobs_.push(std::move(job));
+            // Every queued job must have a thread of its own to run on.
+            if (idle_ < jobs_.size()) spawn_locked();
+        }
+        cv_.notify_one();
+    }
+
+    std::size_t peak_threads() {
+        std::scoped_lock lock(mutex_);
+        return peak_;
+    }
+
+private:
+    void spawn_locked() {
+        for (auto id : retired_) {
+            auto it = std::find_if(workers_.begin(), workers_.end(),
+                                   [id](const std::thread& t) { return t.get_id() == id; });
+            if (it != workers_.end()) {
+                it->join();
+                workers_.erase(it);
+            }
+        }
+        retired_.clear();
+
+        ++live_;
+        peak_ = std::max(peak_, live_);
+        workers_.emplace_back(&AsyncPool::worker_loop, this);
+    }
+
+    void worker_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            ++idle_;
+            bool woke = cv_.wait_for(lock, std::chrono::seconds(1), [this] {
+                return stop_ || !jobs_.empty();
+            });
+            --idle_;
+
+            if (jobs_.empty()) {
+                if (stop_) return;
+                // Extra threads retire when idle; core threads stay.
+                if (!woke && live_ > core_threads_) {
+                    --live_;
+                    retired_.push_back(std::this_thread::get_id());
+                    return;
+                }
+                continue;
+            }
+
+            auto job = std::move(jobs_.front());
+            jobs_.pop();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    const std::size_t core_threads_;
+    std::vector<std::thread> workers_;
+    std::vector<std::thread::id> retired_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::size_t live_ = 0;
+    std::size_t idle_ = 0;
+    std::size_t peak_ = 0;
+    bool stop_ = false;
+};
+
+AsyncPool& global_async_pool() {
+    static AsyncPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+template <typename F, typename... Args>
+auto pooled_async(F&& f, Args&&... args)
+    -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+    using ReturnType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+    auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+        [func = std::forward<F>(f),
+         targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            return std::apply(std::move(func), std::move(targs));
+        });
+    std::future<ReturnType> result = task->get_future();
+    global_async_pool().enqueue([task] { (*task)(); });
+    return result;
+}
+
+// ─── Same-semantics check ────────────────────────────────────────────────────
+
+int slow_square(int x) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return x * x;
+}
+
+void demo_semantics() {
+    std::cout << "=== pooled_async vs std::async semantics ===\n";
+
+    auto f1 = pooled_async(slow_square, 3);
+    auto f2 = pooled_async(slow_square, 4);
+    std::cout << "  results: " << f1.get() << ", " << f2.get() << "\n";
+
+    auto failing = pooled_async([]() -> int { throw std::runtime_error("task failed"); });
+    try {
+        failing.get();
+    } catch (const std::runtime_error& e) {
+        std::cout << "  get() rethrew: " << e.what() << "\n";
+    }
+
+    // A chain where each task blocks on the next: needs a thread per task,
+    // which the pool provides by growing past its core size.
+    std::function<int(int)> chain = [&](int depth) {
+        if (depth == 0) return 0;
+        return pooled_async(chain, depth - 1).get() + 1;
+    };
+    std::cout << "  blocking chain of depth 32 -> " << pooled_async(chain, 32).get()
+              << " (peak pool threads " << global_async_pool().peak_threads() << ")\n\n";
+}
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double calls_per_sec;
+    double p50_us;
+    double p99_us;
+};
+
+// Start latency: call site to first line of the task, one call at a time.
+template <typename Launch>
+Result measure(Launch launch, int calls) {
+    std::vector<double> latencies;
+    latencies.reserve(calls);
+    for (int i = 0; i < calls; ++i) {
+        auto called = Clock::now();
+        Clock::time_point started;
+        launch([&started] { started = Clock::now(); });
+        latencies.push_back(std::chrono::duration<double, std::micro>(started - called).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // Throughput: batches of 64 launches, then wait for the batch.
+    auto start = Clock::now();
+    for (int i = 0; i < calls; i += 64) {
+        std::vector<std::function<void()>> waits;
+        for (int k = 0; k < 64; ++k) waits.push_back(launch.start([] {}));
+        for (auto& w : waits) w();
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    return {calls / secs, latencies[calls / 2], latencies[calls * 99 / 100]};
+}
+
+// Each launcher: operator() runs one task to completion; start() launches one
+// and returns a callable that waits for it.
+struct ThreadLauncher {
+    template <typename F>
+    void operator()(F f) { std::thread(f).join(); }
+    template <typename F>
+    std::function<void()> start(F f) {
+        auto t = std::make_shared<std::thread>(f);
+        return [t] { t->join(); };
+    }
+};
+
+struct AsyncLauncher {
+    template <typename F>
+    void operator()(F f) { std::async(std::launch::async, f).get(); }
+    template <typename F>
+    std::function<void()> start(F f) {
+        auto fut = std::make_shared<std::future<void>>(std::async(std::launch::async, f));
+        return [fut] { fut->get(); };
+    }
+};
+
+struct PooledLauncher {
+    template <typename F>
+    void operator()(F f) { pooled_async(f).get(); }
+    template <typename F>
+    std::function<void()> start(F f) {
+        auto fut = std::make_shared<std::future<void>>(pooled_async(f));
+        return [fut] { fut->get(); };
+    }
+};
+
+void row(const char* name, const Result& r) {
+    std::cout << std::setw(16) << name << std::fixed << std::setprecision(0)
+              << std::setw(14) << r.calls_per_sec << std::setprecision(1)
+              << std::setw(12) << r.p50_us << std::setw(12) << r.p99_us << "\n";
+}
+
+int main() {
+    demo_semantics();
+
+    constexpr int kCalls = 20'000;
+    std::cout << "=== dispatch overhead, " << kCalls << " empty tasks ===\n";
+    std::cout << std::setw(16) << "" << std::setw(14) << "calls/sec" << std::setw(12) << "p50 us"
+              << std::setw(12) << "p99 us\n";
+    row("std::thread", measure(ThreadLauncher{}, kCalls));
+    row("std::async", measure(AsyncLauncher{}, kCalls));
+    row("pooled_async", measure(PooledLauncher{}, kCalls));
+    std::cout << "\nPeak pool threads: " << global_async_pool().peak_threads()
+              << " (bursts of 64 queued calls each get a thread, as std::async would;\n"
+              << "the extras are reused across bursts and retire after 1 s idle)\n";
+    return 0;
+}
@@ -0,0 +1,235 @@
+/**
+ * Adaptive Mutex on Linux futex(2)
+ *
+ * spinlock.cpp compares two extremes:
+ * - Spinlock never sleeps. Great when the holder is about to release, but
+ *   when threads outnumber cores the holder may be descheduled, and every
+ *   waiter burns its whole time slice spinning for nothing.
+ * - std::mutex (glibc's default) sleeps in the kernel almost as soon as it
+ *   sees contention, paying a futex syscall and a wake-up for even the
+ *   shortest wait.
+ *
+ * AdaptiveMutex sits in between, built directly on futex(2):
+ *
+ *   state 0 = unlocked, 1 = locked, 2 = locked and maybe sleepers
+ *
+ * - lock(), uncontended: one CAS 0 -> 1, no syscall
+ * - lock(), contended: spin (read-only, with PAUSE) for a bounded budget;
+ *   if the lock frees up, take it with a CAS. Otherwise mark the state 2
+ *   and FUTEX_WAIT until woken
+ * - unlock(): exchange to 0; only if the old state was 2 is there anyone to
+ *   wake, so FUTEX_WAKE is issued only when waiters may exist
+ *
+ * The spin budget is calibrated once at start-up: PAUSE costs anywhere from
+ * ~10 to ~150 cycles depending on the CPU, so the budget is set in time
+ * (about the cost of a futex sleep/wake round trip), not in iterations.
+ * Each mutex also tracks how long successful spins took (as glibc's
+ * PTHREAD_MUTEX_ADAPTIVE_NP does) and stops spinning sooner on a lock whose
+ * critical sections are long. On a single-CPU machine spinning can never
+ * help, so the budget is zero.
+ *
+ * Linux only.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread adaptive_mutex.cpp
+ */
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#endif
+}
+
+// ─── futex wrappers ──────────────────────────────────────────────────────────
+
+inline void futex_wait(std::atomic<int>& word, int expected) {
+    // Returns immediately (EAGAIN) if word != expected; spurious wake-ups are
+    // fine because the caller re-checks in a loop.
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake_one(std::atomic<int>& word) {
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+// ─── Spin budget calibration ─────────────────────────────────────────────────
+
+// Roughly what a futex sleep + wake costs; spinning longer than this is
+// worse than sleeping.
+constexpr double kSpinBudgetNs = 4000;
+
+int calibrate_spin_limit() {
+    if (std::thread::hardware_concurrency() <= 1) return 0;
+
+    constexpr int kPauses = 20'000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPauses; ++i) cpu_relax();
+    double ns_per_pause = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / kPauses;
+    return static_cast<int>(std::clamp(kSpinBudgetNs / std::max(ns_per_pause, 0.1), 16.0, 100'000.0));
+}
+
+const int g_spin_limit = calibrate_spin_limit();
+
+// ─── AdaptiveMutex ───────────────────────────────────────────────────────────
+
+class AdaptiveMutex {
+public:
+    void lock() noexcept {
+        int expected = 0;
+        if (state_.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+            return;  // fast path: uncontended
+        }
+        if (!spin_then_try()) sleep_until_acquired();
+    }
+
+    bool try_lock() noexcept {
+        int expected = 0;
+        return state_.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept {
+        if (state_.exchange(0, std::memory_order_release) == 2) {
+            futex_wake_one(state_);
+        }
+    }
+
+private:
+    // Spin up to min(2 * average + 16, g_spin_limit) pauses.
+    bool spin_then_try() noexcept {
+        int avg = spin_avg_.load(std::memory_order_relaxed);
+        int limit = std::min(g_spin_limit, 2 * avg + 16);
+        for (int i = 0; i < limit; ++i) {
+            if (state_.load(std::memory_order_relaxed) == 0) {
+                int expected = 0;
+                if (state_.compare_exchange_weak(expected, 1, std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+                    // Moving average of successful spin lengths (1/8 weight).
+                    spin_avg_.store(avg + (i - avg) / 8, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            cpu_relax();
+        }
+        // Spinning didn't pay off: lean towards sleeping sooner next time.
+        spin_avg_.store(avg - avg / 8, std::memory_order_relaxed);
+        return false;
+    }
+
+    void sleep_until_acquired() noexcept {
+        // Mark "maybe sleepers" before sleeping so unlock() knows to wake us.
+        // Once woken we keep state 2: other sleepers may still be queued.
+        while (state_.exchange(2, std::memory_order_acquire) != 0) {
+            futex_wait(state_, 2);
+        }
+    }
+
+    std::atomic<int> state_{0};
+    std::atomic<int> spin_avg_{g_spin_limit / 2};  // racy by design: a hint only
+};
+
+// ─── spinlock.cpp's Spinlock ─────────────────────────────────────────────────
+
+class Spinlock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            cpu_relax();
+        }
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+// ─── Benchmark (spinlock.cpp's harness) ──────────────────────────────────────
+
+template <typename F>
+long benchmark_ms(F&& func, int num_threads) {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_threads; ++i) threads.emplace_back(func);
+    for (auto& t : threads) t.join();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+double process_cpu_ms() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+void busy_ns(int ns) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+constexpr int kIterations = 100'000;
+
+// Short critical sections, with every 500th one long (20 us): the
+// "short but occasionally long" shape where neither pure strategy fits.
+template <typename Lock>
+void run(const char* name, int num_threads) {
+    Lock lock;
+    long counter = 0;
+    double cpu_before = process_cpu_ms();
+    long ms = benchmark_ms([&] {
+        for (int i = 0; i < kIterations; ++i) {
+            std::lock_guard<Lock> guard(lock);
+            ++counter;
+            if (i % 500 == 0) busy_ns(20'000);
+        }
+    }, num_threads);
+    double cpu_ms = process_cpu_ms() - cpu_before;
+
+    bool ok = counter == static_cast<long>(kIterations) * num_threads;
+    std::cout << "  " << std::left << std::setw(14) << name << std::right << std::setw(8) << ms
+              << " ms wall" << std::setw(10) << static_cast<long>(cpu_ms) << " ms CPU"
+              << (ok ? "" : "   WRONG COUNT") << "\n";
+}
+
+void scenario(const char* title, int num_threads) {
+    std::cout << title << " (" << num_threads << " threads):\n";
+    run<Spinlock>("Spinlock", num_threads);
+    run<std::mutex>("std::mutex", num_threads);
+    run<AdaptiveMutex>("AdaptiveMutex", num_threads);
+    std::cout << "\n";
+}
+
+int main() {
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores == 0) cores = 2;
+    std::cout << "Cores: " << cores << ", spin limit: " << g_spin_limit << " pauses\n\n";
+
+    scenario("Uncontended", 1);
+    if (cores > 1) scenario("Threads = cores", cores);
+    scenario("Oversubscribed, threads = 4 x cores", 4 * cores);
+
+    std::cout << "CPU time well above wall time x min(threads, cores) is time burned\n"
+              << "spinning. Oversubscribed, Spinlock waiters spin through their time\n"
+              << "slices while the holder is descheduled; AdaptiveMutex gives up after\n"
+              << "its spin budget and sleeps in FUTEX_WAIT instead.\n";
+    return 0;
+}
@@ -0,0 +1,338 @@
+/**
+ * Task Dispatch Overhead Microbenchmark
+ *
+ * What does it cost to run an empty task? This binary measures every
+ * dispatch mechanism used in the examples, side by side:
+ *
+ *   thread         std::thread per task, then join (thread_life_cycle.cpp)
+ *   packaged_task  std::packaged_task moved onto a new std::thread
+ *                  (packaged_task.cpp)
+ *   async          std::async(std::launch::async)
+ *   pool_enqueue   ThreadPool::enqueue, completion via a counter
+ *                  (thread_pool.cpp)
+ *   pool_submit    ThreadPool::submit returning std::future
+ *                  (thread_pool_futures.cpp)
+ *
+ * Every case uses the same protocol: each producer thread launches a batch
+ * of 32 empty tasks, waits for all of them, and repeats. Reported per case:
+ * - throughput   tasks completed per second, all producers combined
+ * - latency      launch call to first instruction of the task body,
+ *                p50 / p90 / p99 / p99.9 in nanoseconds
+ *
+ * The sweep covers 1/2/4 producers, 1/2/4 pool workers (pool mechanisms
+ * only) and unpinned vs pinned (producers and workers bound round-robin to
+ * the allowed CPUs with pthread_setaffinity_np). Results print as a table
+ * and are written as JSON to track regressions across commits:
+ *
+ *   [{"mechanism": "pool_submit", "producers": 1, "workers": 4,
+ *     "pinned": false, "tasks": 40000, "throughput_per_sec": ...,
+ *     "latency_ns": {"p50": ..., "p90": ..., "p99": ..., "p999": ...}}, ...]
+ *
+ * Linux only (thread affinity).
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread dispatch_benchmark.cpp
+ * Run:     ./a.out [output.json]   (default dispatch_benchmark.json)
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// ─── Affinity ────────────────────────────────────────────────────────────────
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+}
+
+void pin_current_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// ─── ThreadPool (thread_pool_futures.cpp) with optional pinning ──────────────
+
+class ThreadPool {
+public:
+    ThreadPool(std::size_t num_threads, bool pin) {
+        auto cpus = allowed_cpus();
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this, pin, cpu = cpus[i % cpus.size()]] {
+                if (pin) pin_current_thread(cpu);
+                worker_loop();
+            });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    void enqueue(std::function<void()> job) {
+        {
+            std::scoped_lock lock(mutex_);
+            queue_.push(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+        std::future<ReturnType> result = task->get_future();
+        enqueue([task] { (*task)(); });
+        return result;
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+                if (shutdown_ && queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread>          workers_;
+    std::queue<std::function<void()>> queue_;
+    std::mutex                        mutex_;
+    std::condition_variable           cv_;
+    bool                              shutdown_{false};
+};
+
+// ─── Mechanisms ──────────────────────────────────────────────────────────────
+
+constexpr int kBatch = 32;
+
+// One task's timing slot: launched just before dispatch, started by the body.
+struct Slot {
+    Clock::time_point launched;
+    Clock::time_point started;
+};
+
+// Each mechanism runs one batch of empty tasks and returns when all are done.
+using BatchRunner = std::function<void(Slot* slots, int n)>;
+
+void thread_batch(Slot* slots, int n) {
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        Slot* s = &slots[i];
+        s->launched = Clock::now();
+        threads.emplace_back([s] { s->started = Clock::now(); });
+    }
+    for (auto& t : threads) t.join();
+}
+
+void packaged_task_batch(Slot* slots, int n) {
+    std::vector<std::thread> threads;
+    std::vector<std::future<void>> futures;
+    threads.reserve(n);
+    futures.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        Slot* s = &slots[i];
+        s->launched = Clock::now();
+        std::packaged_task<void()> task([s] { s->started = Clock::now(); });
+        futures.push_back(task.get_future());
+        threads.emplace_back(std::move(task));
+    }
+    for (auto& f : futures) f.get();
+    for (auto& t : threads) t.join();
+}
+
+void async_batch(Slot* slots, int n) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        Slot* s = &slots[i];
+        s->launched = Clock::now();
+        futures.push_back(std::async(std::launch::async, [s] { s->started = Clock::now(); }));
+    }
+    for (auto& f : futures) f.get();
+}
+
+BatchRunner enqueue_batch(ThreadPool& pool) {
+    return [&pool](Slot* slots, int n) {
+        std::atomic<int> remaining{n};
+        for (int i = 0; i < n; ++i) {
+            Slot* s = &slots[i];
+            s->launched = Clock::now();
+            pool.enqueue([s, &remaining] {
+                s->started = Clock::now();
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        while (remaining.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+    };
+}
+
+BatchRunner submit_batch(ThreadPool& pool) {
+    return [&pool](Slot* slots, int n) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            Slot* s = &slots[i];
+            s->launched = Clock::now();
+            futures.push_back(pool.submit([s] { s->started = Clock::now(); }));
+        }
+        for (auto& f : futures) f.get();
+    };
+}
+
+// ─── Runner ──────────────────────────────────────────────────────────────────
+
+struct Result {
+    std::string mechanism;
+    int producers;
+    int workers;  // 0 = not a pool mechanism
+    bool pinned;
+    std::size_t tasks;
+    double throughput;
+    double p50, p90, p99, p999;
+};
+
+Result run_case(const std::string& name, const BatchRunner& batch, int producers, int workers,
+                bool pinned, int tasks_per_producer) {
+    auto cpus = allowed_cpus();
+    int batches = tasks_per_producer / kBatch;
+    std::vector<std::vector<Slot>> slots(producers, std::vector<Slot>(batches * kBatch));
+
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            // Producers take the CPUs after the workers' in round-robin order.
+            if (pinned) pin_current_thread(cpus[(workers + p) % cpus.size()]);
+            ready.fetch_add(1);
+            while (!go.load()) std::this_thread::yield();
+            for (int b = 0; b < batches; ++b) batch(&slots[p][b * kBatch], kBatch);
+        });
+    }
+    while (ready.load() != producers) std::this_thread::yield();
+
+    auto start = Clock::now();
+    go = true;
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    for (auto& per_producer : slots) {
+        for (auto& s : per_producer) {
+            latencies.push_back(std::chrono::duration<double, std::nano>(s.started - s.launched).count());
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double q) { return latencies[static_cast<std::size_t>(q * (latencies.size() - 1))]; };
+
+    return {name, producers, workers, pinned, latencies.size(), latencies.size() / secs,
+            pct(0.50), pct(0.90), pct(0.99), pct(0.999)};
+}
+
+std::string to_json(const std::vector<Result>& results) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "  {\"mechanism\": \"" << r.mechanism << "\", \"producers\": " << r.producers
+            << ", \"workers\": " << r.workers << ", \"pinned\": " << (r.pinned ? "true" : "false")
+            << ", \"tasks\": " << r.tasks << ", \"throughput_per_sec\": " << r.throughput
+            << ", \"latency_ns\": {\"p50\": " << r.p50 << ", \"p90\": " << r.p90
+            << ", \"p99\": " << r.p99 << ", \"p999\": " << r.p999 << "}}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+    return out.str();
+}
+
+void print_row(const Result& r) {
+    std::cout << std::left << std::setw(15) << r.mechanism << std::right << std::setw(5) << r.producers
+              << std::setw(5) << (r.workers ? std::to_string(r.workers) : "-")
+              << std::setw(5) << (r.pinned ? "yes" : "no") << std::fixed << std::setprecision(0)
+              << std::setw(13) << r.throughput << std::setw(10) << r.p50 << std::setw(10) << r.p90
+              << std::setw(10) << r.p99 << std::setw(11) << r.p999 << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "dispatch_benchmark.json";
+
+    // Fresh threads are ~10x slower to dispatch, so they get fewer tasks.
+    constexpr int kThreadTasks = 2'048;
+    constexpr int kPoolTasks = 16'384;
+
+    std::cout << "Allowed CPUs: " << allowed_cpus().size() << "\n\n";
+    std::cout << std::left << std::setw(15) << "mechanism" << std::right << std::setw(5) << "prod"
+              << std::setw(5) << "wrk" << std::setw(5) << "pin" << std::setw(13) << "tasks/s"
+              << std::setw(10) << "p50 ns" << std::setw(10) << "p90 ns" << std::setw(10) << "p99 ns"
+              << std::setw(11) << "p99.9 ns\n";
+
+    std::vector<Result> results;
+    auto record = [&](Result r) {
+        print_row(r);
+        results.push_back(std::move(r));
+    };
+
+    for (bool pinned : {false, true}) {
+        for (int producers : {1, 2, 4}) {
+            record(run_case("thread", thread_batch, producers, 0, pinned, kThreadTasks));
+            record(run_case("packaged_task", packaged_task_batch, producers, 0, pinned, kThreadTasks));
+            record(run_case("async", async_batch, producers, 0, pinned, kThreadTasks));
+            for (int workers : {1, 2, 4}) {
+                ThreadPool pool(workers, pinned);
+                record(run_case("pool_enqueue", enqueue_batch(pool), producers, workers, pinned, kPoolTasks));
+                record(run_case("pool_submit", submit_batch(pool), producers, workers, pinned, kPoolTasks));
+            }
+        }
+    }
+
+    std::ofstream(path) << to_json(results);
+    std::cout << "\nWrote " << results.size() << " results to " << path << "\n";
+    return 0;
+}
@@ -0,0 +1,314 @@
+/**
+ * Elastic Thread Pool
+ *
+ * ThreadPool (thread_pool.cpp) starts num_threads workers in its constructor
+ * and keeps them forever. Sized for the peak, most threads sit idle; sized
+ * for the average, the pool runs dry during spikes, especially when tasks
+ * block on I/O and hold their worker without using the CPU.
+ *
+ * The elastic pool keeps between min_threads and max_threads workers:
+ * - Grow: when no worker is idle and either the queue is deeper than
+ *   queue_depth_threshold or the oldest queued task has waited longer than
+ *   queue_wait_threshold, a new worker is started
+ * - Rate limit: at most one new worker per spawn_interval, so a brief burst
+ *   does not create a thundering herd of threads
+ * - Shrink: a worker that has been idle for idle_timeout exits, as long as
+ *   more than min_threads remain
+ *
+ * Queue depth is checked on enqueue(). Queue wait is checked by a small
+ * monitor thread, because when every worker is blocked inside a task
+ * nobody else would notice that the queue has stopped moving. The monitor
+ * only wakes on a timer while tasks are queued and no worker is idle;
+ * otherwise it blocks until that happens or a worker retires, and it joins
+ * retired workers as soon as they exit.
+ *
+ * The sawtooth test ramps the load of blocking tasks up and down and prints
+ * thread count and queue-wait latency over time.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread elastic_thread_pool.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct ElasticOptions {
+    size_t min_threads = 2;
+    size_t max_threads = 32;
+    size_t queue_depth_threshold = 4;
+    std::chrono::milliseconds queue_wait_threshold{2};
+    std::chrono::milliseconds idle_timeout{100};
+    std::chrono::milliseconds spawn_interval{1};
+};
+
+class ElasticThreadPool {
+public:
+    explicit ElasticThreadPool(ElasticOptions options = {}) : options_(options) {
+        if (options_.min_threads == 0 || options_.min_threads > options_.max_threads)
+            throw std::invalid_argument("require 0 < min_threads <= max_threads");
+
+        std::scoped_lock lock(mutex_);
+        for (size_t i = 0; i < options_.min_threads; ++i) {
+            spawn_locked();
+        }
+        monitor_ = std::thread(&ElasticThreadPool::monitor_loop, this);
+    }
+
+    ~ElasticThreadPool() {
+        {
+            std::scoped_lock lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        monitor_cv_.notify_all();
+        monitor_.join();
+
+        // No new workers can be spawned once stop_ is set.
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ElasticThreadPool(const ElasticThreadPool&) = delete;
+    ElasticThreadPool& operator=(const ElasticThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (stop_)
+                throw std::runtime_error("enqueue() called on a stopped ElasticThreadPool");
+            tasks_.push_back({std::move(task), Clock::now()});
+            if (idle_ == 0 && tasks_.size() > options_.queue_depth_threshold) {
+                maybe_grow_locked();
+            }
+            if (backlogged_locked()) monitor_cv_.notify_one();
+        }
+        cv_.notify_one();
+    }
+
+    size_t thread_count() const {
+        std::scoped_lock lock(mutex_);
+        return live_;
+    }
+
+    size_t queue_depth() const {
+        std::scoped_lock lock(mutex_);
+        return tasks_.size();
+    }
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        Clock::time_point enqueued;
+    };
+
+    void spawn_locked() {
+        reap_locked();
+        ++live_;
+        last_spawn_ = Clock::now();
+        workers_.emplace_back(&ElasticThreadPool::worker_loop, this);
+    }
+
+    void maybe_grow_locked() {
+        if (stop_ || live_ >= options_.max_threads) return;
+        if (Clock::now() - last_spawn_ < options_.spawn_interval) return;
+        spawn_locked();
+    }
+
+    // Join workers that have retired. Their std::thread objects are still in
+    // workers_ until someone joins them.
+    void reap_locked() {
+        for (auto id : retired_) {
+            auto it = std::find_if(workers_.begin(), workers_.end(),
+                                   [id](const std::thread& t) { return t.get_id() == id; });
+            if (it != workers_.end()) {
+                it->join();
+                workers_.erase(it);
+            }
+        }
+        retired_.clear();
+    }
+
+    // Tasks are waiting and no worker is free to take them.
+    bool backlogged_locked() const { return !tasks_.empty() && idle_ == 0; }
+
+    void monitor_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            reap_locked();
+
+            if (!backlogged_locked()) {
+                monitor_cv_.wait(lock, [this] {
+                    return stop_ || !retired_.empty() || backlogged_locked();
+                });
+                continue;
+            }
+
+            if (live_ >= options_.max_threads) {
+                // Nothing to do until a worker retires and frees a slot.
+                monitor_cv_.wait(lock, [this] {
+                    return stop_ || !retired_.empty() || live_ < options_.max_threads;
+                });
+                continue;
+            }
+
+            auto deadline = tasks_.front().enqueued + options_.queue_wait_threshold;
+            if (Clock::now() >= deadline) {
+                maybe_grow_locked();
+                // Rate limited or just grown: look again once the next
+                // spawn would be allowed.
+                deadline = last_spawn_ + options_.spawn_interval;
+            }
+            monitor_cv_.wait_until(lock, deadline);
+        }
+    }
+
+    void worker_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            ++idle_;
+            bool woke = cv_.wait_for(lock, options_.idle_timeout, [this] {
+                return stop_ || !tasks_.empty();
+            });
+            --idle_;
+
+            if (stop_ && tasks_.empty()) {
+                --live_;
+                return;
+            }
+
+            if (!woke) {
+                // Idle for a full timeout: retire if above the floor.
+                if (live_ > options_.min_threads) {
+                    --live_;
+                    retired_.push_back(std::this_thread::get_id());
+                    monitor_cv_.notify_one();  // join us
+                    return;
+                }
+                continue;
+            }
+
+            Job job = std::move(tasks_.front());
+            tasks_.pop_front();
+            if (backlogged_locked()) monitor_cv_.notify_one();
+
+            lock.unlock();
+            job.fn();
+            lock.lock();
+        }
+    }
+
+    ElasticOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable monitor_cv_;
+    std::deque<Job> tasks_;
+    std::vector<std::thread> workers_;
+    std::vector<std::thread::id> retired_;
+    std::thread monitor_;
+    Clock::time_point last_spawn_{};
+    size_t live_ = 0;
+    size_t idle_ = 0;
+    bool stop_ = false;
+};
+
+// ─── Sawtooth load test ──────────────────────────────────────────────────────
+//
+// Each "tooth" ramps the submission rate of 1 ms blocking tasks from 0 to
+// kPeakRate per millisecond over kRampMs, then drops to zero for kQuietMs.
+
+constexpr int kTeeth = 3;
+constexpr int kRampMs = 300;
+constexpr int kQuietMs = 300;
+constexpr int kPeakRate = 12;          // tasks submitted per ms at the peak
+constexpr int kSampleEveryMs = 50;
+
+struct Window {
+    std::atomic<long> started{0};
+    std::atomic<long> wait_us_total{0};
+    std::atomic<long> wait_us_max{0};
+};
+
+int main() {
+    ElasticOptions options;
+    options.min_threads = 2;
+    options.max_threads = 24;
+    options.idle_timeout = std::chrono::milliseconds(50);
+
+    ElasticThreadPool pool(options);
+
+    const int total_ms = kTeeth * (kRampMs + kQuietMs);
+    std::vector<Window> windows(total_ms / kSampleEveryMs + 1);
+    std::vector<size_t> threads_at(windows.size()), depth_at(windows.size());
+
+    auto start = Clock::now();
+    auto elapsed_ms = [&] {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - start).count());
+    };
+
+    std::atomic<long> outstanding{0};
+    int last_sample = -1;
+    for (int ms = 0; ms < total_ms; ++ms) {
+        int phase = ms % (kRampMs + kQuietMs);
+        int rate = phase < kRampMs ? (kPeakRate * phase) / kRampMs : 0;
+
+        for (int i = 0; i < rate; ++i) {
+            auto enqueued = Clock::now();
+            outstanding.fetch_add(1);
+            pool.enqueue([&, enqueued] {
+                auto now = Clock::now();
+                long wait_us = std::chrono::duration_cast<std::chrono::microseconds>(now - enqueued).count();
+                auto& w = windows[std::min<size_t>(elapsed_ms() / kSampleEveryMs, windows.size() - 1)];
+                w.started.fetch_add(1);
+                w.wait_us_total.fetch_add(wait_us);
+                long prev = w.wait_us_max.load();
+                while (wait_us > prev && !w.wait_us_max.compare_exchange_weak(prev, wait_us)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));  // blocking I/O
+                outstanding.fetch_sub(1);
+            });
+        }
+
+        int sample = ms / kSampleEveryMs;
+        if (sample != last_sample) {
+            threads_at[sample] = pool.thread_count();
+            depth_at[sample] = pool.queue_depth();
+            last_sample = sample;
+        }
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(ms + 1));
+    }
+    while (outstanding.load() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::cout << "Sawtooth load: " << kTeeth << " ramps of 0.." << kPeakRate
+              << " blocking 1 ms tasks per ms, min=" << options.min_threads
+              << " max=" << options.max_threads << " threads\n\n";
+    std::cout << std::setw(8) << "t (ms)" << std::setw(9) << "threads" << std::setw(8) << "queue"
+              << std::setw(9) << "tasks" << std::setw(14) << "avg wait us"
+              << std::setw(14) << "max wait us" << "\n";
+    for (size_t i = 0; i + 1 < windows.size(); ++i) {
+        long n = windows[i].started.load();
+        std::cout << std::setw(8) << i * kSampleEveryMs
+                  << std::setw(9) << threads_at[i]
+                  << std::setw(8) << depth_at[i]
+                  << std::setw(9) << n
+                  << std::setw(14) << (n ? windows[i].wait_us_total.load() / n : 0)
+                  << std::setw(14) << windows[i].wait_us_max.load() << "\n";
+    }
+
+    std::this_thread::sleep_for(options.idle_timeout * 3);
+    std::cout << "\nThreads after the load is gone: " << pool.thread_count()
+              << " (min_threads = " << options.min_threads << ")\n";
+    return 0;
+}
@@ -0,0 +1,455 @@
+/**
+ * Help-While-Waiting Fork/Join
+ *
+ * parallel_sum (recursive_sum.cpp) and parallel_sort (merge_sort.cpp) fork
+ * with std::async / std::thread at every split and then block in get() or
+ * join(). Every split costs an OS thread, and the parent thread sits idle
+ * until its child finishes. That is why both need a max_depth limit: raise
+ * it and you get thousands of mostly blocked threads.
+ *
+ * join(a, b) on a fork/join pool works differently:
+ * - b is pushed onto the calling worker's own deque, a runs inline
+ * - if nobody stole b, the worker pops it back and runs it inline too,
+ *   which makes an uncontended join no more than two function calls
+ * - if b was stolen, the worker does not block: it steals and runs other
+ *   pending jobs until b's thief marks it done
+ * Jobs live on the stack of the join() that created them, so forking
+ * allocates nothing. The thread count is the pool size no matter how deep
+ * the recursion goes, so the depth limit becomes a plain grain size.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread fork_join.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─── Jobs ────────────────────────────────────────────────────────────────────
+
+struct Job {
+    explicit Job(void (*fn)(Job*)) : invoke(fn) {}
+
+    void (*invoke)(Job*);
+    std::atomic<bool> done{false};
+    std::exception_ptr error;
+};
+
+template <typename F>
+struct FnJob : Job {
+    explicit FnJob(F& f) : Job(&FnJob::run), fn(f) {}
+
+    static void run(Job* job) {
+        auto* self = static_cast<FnJob*>(job);
+        try {
+            self->fn();
+        } catch (...) {
+            self->error = std::current_exception();
+        }
+        self->done.store(true, std::memory_order_release);
+    }
+
+    F& fn;
+};
+
+// A job an outside (non-worker) thread blocks on: completion is published
+// under a mutex, so the waiter can use a plain untimed wait.
+template <typename F>
+struct BlockingJob : Job {
+    explicit BlockingJob(F& f) : Job(&BlockingJob::run), fn(f) {}
+
+    static void run(Job* job) {
+        auto* self = static_cast<BlockingJob*>(job);
+        try {
+            self->fn();
+        } catch (...) {
+            self->error = std::current_exception();
+        }
+        // Notify with the lock held: once it is released the waiter may
+        // return and destroy this job.
+        std::scoped_lock lock(self->mutex);
+        self->done.store(true, std::memory_order_release);
+        self->cv.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return done.load(std::memory_order_relaxed); });
+    }
+
+    F& fn;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+// ─── Pool ────────────────────────────────────────────────────────────────────
+
+class ForkJoinPool {
+public:
+    explicit ForkJoinPool(size_t num_threads) : queues_(num_threads), stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ForkJoinPool::worker_loop, this, i);
+        }
+    }
+
+    ~ForkJoinPool() {
+        {
+            std::scoped_lock lock(sleep_mutex_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    // Run a and b, potentially in parallel; returns when both are done.
+    // From outside the pool, the pair is handed to a worker and the caller blocks.
+    template <typename A, typename B>
+    void join(A&& a, B&& b) {
+        if (current_pool_ != this) {
+            run([&] { join(a, b); });
+            return;
+        }
+
+        FnJob<B> job_b(b);
+        push_local(&job_b);
+
+        std::exception_ptr error_a;
+        try {
+            a();
+        } catch (...) {
+            error_a = std::current_exception();
+        }
+
+        // Fast path: b is still on our deque, run it here.
+        if (pop_local_if(&job_b)) {
+            job_b.invoke(&job_b);
+        } else {
+            // b was stolen: help with other work until its thief finishes.
+            while (!job_b.done.load(std::memory_order_acquire)) {
+                if (Job* other = steal()) {
+                    other->invoke(other);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        if (error_a) std::rethrow_exception(error_a);
+        if (job_b.error) std::rethrow_exception(job_b.error);
+    }
+
+    // Run f on a worker and block the (non-worker) caller until it returns.
+    template <typename F>
+    void run(F&& f) {
+        BlockingJob<F> job(f);
+        {
+            std::scoped_lock lock(inject_mutex_);
+            injected_.push_back(&job);
+        }
+        published();
+        job.wait();
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job*> jobs;  // owner: back, thieves: front
+    };
+
+    void push_local(Job* job) {
+        {
+            std::scoped_lock lock(queues_[worker_index_].mutex);
+            queues_[worker_index_].jobs.push_back(job);
+        }
+        published();
+    }
+
+    // Sleeper/pending handshake. A pusher increments pending_ and then reads
+    // sleepers_; a worker going to sleep increments sleepers_ and then
+    // re-checks pending_ under sleep_mutex_. Both are seq_cst, so at least
+    // one side sees the other: either the worker stays awake, or the pusher
+    // notifies, and since it takes sleep_mutex_ first the notify cannot slip
+    // in between the worker's check and its wait.
+    void published() {
+        pending_.fetch_add(1);
+        if (sleepers_.load() > 0) wake_one();
+    }
+
+    bool pop_local_if(Job* expected) {
+        auto& q = queues_[worker_index_];
+        std::scoped_lock lock(q.mutex);
+        if (q.jobs.empty() || q.jobs.back() != expected) return false;
+        q.jobs.pop_back();
+        pending_.fetch_sub(1);
+        return true;
+    }
+
+    Job* steal() {
+        {
+            std::scoped_lock lock(inject_mutex_);
+            if (!injected_.empty()) {
+                Job* job = injected_.front();
+                injected_.pop_front();
+                pending_.fetch_sub(1);
+                return job;
+            }
+        }
+        size_t n = queues_.size();
+        size_t start = current_pool_ == this ? worker_index_ + 1 : 0;
+        for (size_t k = 0; k < n; ++k) {
+            auto& q = queues_[(start + k) % n];
+            std::scoped_lock lock(q.mutex);
+            if (!q.jobs.empty()) {
+                Job* job = q.jobs.front();
+                q.jobs.pop_front();
+                pending_.fetch_sub(1);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void wake_one() {
+        std::scoped_lock lock(sleep_mutex_);
+        sleep_cv_.notify_one();
+    }
+
+    void worker_loop(size_t index) {
+        current_pool_ = this;
+        worker_index_ = index;
+
+        while (true) {
+            if (Job* job = steal()) {
+                job->invoke(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            if (stop_) return;
+            sleepers_.fetch_add(1);
+            sleep_cv_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    static thread_local ForkJoinPool* current_pool_;
+    static thread_local size_t worker_index_;
+
+    std::vector<WorkerQueue> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex inject_mutex_;
+    std::deque<Job*> injected_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<long> pending_{0};  // jobs sitting in any deque or injected_
+    std::atomic<int> sleepers_{0};
+    bool stop_;
+};
+
+thread_local ForkJoinPool* ForkJoinPool::current_pool_ = nullptr;
+thread_local size_t ForkJoinPool::worker_index_ = 0;
+
+// ─── Port 1: parallel_sum (recursive_sum.cpp) ────────────────────────────────
+
+unsigned long long serial_sum(unsigned int lo, unsigned int hi) {
+    unsigned long long sum = 0;
+    for (unsigned int i = lo; i < hi; ++i) {
+        sum += i;
+    }
+    return sum;
+}
+
+// Original: std::async at every split, blocking get().
+unsigned long long async_sum(unsigned int lo, unsigned int hi, int max_depth, int depth = 0) {
+    if (depth >= max_depth || hi - lo < 1000) {
+        return serial_sum(lo, hi);
+    }
+    unsigned int mid = lo + (hi - lo) / 2;
+    auto left = std::async(std::launch::async, async_sum, lo, mid, max_depth, depth + 1);
+    unsigned long long right = async_sum(mid, hi, max_depth, depth + 1);
+    return left.get() + right;
+}
+
+// Fork/join: no depth limit, only a grain size.
+unsigned long long parallel_sum(ForkJoinPool& pool, unsigned int lo, unsigned int hi) {
+    if (hi - lo < (1u << 16)) {
+        return serial_sum(lo, hi);
+    }
+    unsigned int mid = lo + (hi - lo) / 2;
+    unsigned long long left = 0, right = 0;
+    pool.join([&] { left = parallel_sum(pool, lo, mid); },
+              [&] { right = parallel_sum(pool, mid, hi); });
+    return left + right;
+}
+
+// ─── Port 2: parallel_sort (merge_sort.cpp) ──────────────────────────────────
+
+void merge(std::vector<int>& arr, int left, int mid, int right) {
+    std::vector<int> temp(right - left + 1);
+    int i = left, j = mid + 1, k = 0;
+
+    while (i <= mid && j <= right) {
+        if (arr[i] <= arr[j]) {
+            temp[k++] = arr[i++];
+        } else {
+            temp[k++] = arr[j++];
+        }
+    }
+
+    while (i <= mid) temp[k++] = arr[i++];
+    while (j <= right) temp[k++] = arr[j++];
+
+    std::copy(temp.begin(), temp.end(), arr.begin() + left);
+}
+
+void sequential_sort(std::vector<int>& arr, int left, int right) {
+    if (left < right) {
+        int mid = left + (right - left) / 2;
+        sequential_sort(arr, left, mid);
+        sequential_sort(arr, mid + 1, right);
+        merge(arr, left, mid, right);
+    }
+}
+
+// Original: std::thread per split down to max_depth.
+void thread_sort(std::vector<int>& arr, int left, int right, int max_depth, int depth = 0) {
+    if (left >= right) return;
+    int mid = left + (right - left) / 2;
+    if (depth < max_depth) {
+        std::thread left_thread(thread_sort, std::ref(arr), left, mid, max_depth, depth + 1);
+        thread_sort(arr, mid + 1, right, max_depth, depth + 1);
+        left_thread.join();
+    } else {
+        sequential_sort(arr, left, mid);
+        sequential_sort(arr, mid + 1, right);
+    }
+    merge(arr, left, mid, right);
+}
+
+// Fork/join: split until 2048 elements, whatever the core count.
+void parallel_sort(ForkJoinPool& pool, std::vector<int>& arr, int left, int right) {
+    if (right - left < 2048) {
+        sequential_sort(arr, left, right);
+        return;
+    }
+    int mid = left + (right - left) / 2;
+    pool.join([&] { parallel_sort(pool, arr, left, mid); },
+              [&] { parallel_sort(pool, arr, mid + 1, right); });
+    merge(arr, left, mid, right);
+}
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+int os_thread_count() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "Threads:") {
+            int n = 0;
+            status >> n;
+            return n;
+        }
+    }
+    return 0;
+}
+
+// Runs f while sampling the process thread count; returns {ms, peak threads}.
+template <typename F>
+std::pair<double, int> measure(F&& f) {
+    std::atomic<bool> running{true};
+    std::atomic<int> peak{os_thread_count()};
+    std::thread sampler([&] {
+        while (running.load()) {
+            int now = os_thread_count();
+            if (now > peak.load()) peak.store(now);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+
+    running = false;
+    sampler.join();
+    return {ms, peak.load() - 1};  // don't count the sampler itself
+}
+
+void row(const std::string& name, std::pair<double, int> r, bool ok) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(9) << r.first << " ms"
+              << std::setw(8) << r.second << " threads" << (ok ? "" : "  WRONG RESULT") << "\n";
+}
+
+int main() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores == 0) cores = 2;
+    ForkJoinPool pool(cores);
+    std::cout << "Cores: " << cores << " (fork/join pool has " << pool.thread_count()
+              << " workers; thread counts include main)\n";
+
+    // ── parallel_sum ──────────────────────────────────────────────────
+    constexpr unsigned int N = 200'000'000;
+    const unsigned long long expected = (unsigned long long)(N - 1) * N / 2;
+    std::cout << "\nSum of 0.." << N - 1 << ":\n";
+
+    for (int depth : {4, 8, 10}) {
+        unsigned long long got = 0;
+        auto r = measure([&] { got = async_sum(0, N, depth); });
+        row("std::async, max_depth " + std::to_string(depth), r, got == expected);
+    }
+    {
+        unsigned long long got = 0;
+        auto r = measure([&] { got = parallel_sum(pool, 0, N); });
+        row("fork/join, grain 64K (depth ~12)", r, got == expected);
+    }
+
+    // ── parallel_sort ─────────────────────────────────────────────────
+    constexpr int kSize = 1'000'000;
+    std::vector<int> original(kSize);
+    for (int& x : original) x = rand();
+    std::vector<int> expected_sorted = original;
+    std::sort(expected_sorted.begin(), expected_sorted.end());
+    std::cout << "\nMerge sort of " << kSize << " ints:\n";
+
+    int default_depth = static_cast<int>(std::log2(cores));
+    for (int depth : {default_depth, 6, 9}) {
+        std::vector<int> arr = original;
+        auto r = measure([&] { thread_sort(arr, 0, kSize - 1, depth); });
+        row("std::thread, max_depth " + std::to_string(depth), r, arr == expected_sorted);
+    }
+    {
+        std::vector<int> arr = original;
+        auto r = measure([&] { parallel_sort(pool, arr, 0, kSize - 1); });
+        row("fork/join, grain 2048 (depth ~9)", r, arr == expected_sorted);
+    }
+
+    std::cout << "\nThe std::async/std::thread versions need one OS thread per split,\n"
+              << "so their thread count doubles with every extra level. The fork/join\n"
+              << "pool stays at its worker count however deep the recursion goes.\n";
+    return 0;
+}
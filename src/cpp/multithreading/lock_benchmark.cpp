@@ -0,0 +1,492 @@
+/**
+ * Lock Benchmark Matrix: Throughput, Tail Latency and Fairness
+ *
+ * starvation.cpp and mutex_contention.cpp show unfairness by printing
+ * per-thread counts and leaving the reader to eyeball them. This binary
+ * measures it, for every lock type used in the examples:
+ *
+ *   std::mutex, std::recursive_mutex, std::timed_mutex,
+ *   std::shared_mutex (exclusive), Spinlock, TTASLock, TicketLock,
+ *   MCSLock, CLHLock (spinlock_family.cpp), AdaptiveMutex (adaptive_mutex.cpp)
+ *
+ * Each run starts N threads that loop for a fixed time:
+ *
+ *   lock(); <critical-section work>; unlock(); <non-critical work>
+ *
+ * and the sweep covers thread count x critical-section length x
+ * non-critical work (work is a dependent multiply-add chain of the given
+ * length; 0 means back-to-back acquisitions). Reported per run:
+ * - throughput   acquisitions per second, all threads combined
+ * - p99 acquire  time spent inside lock(), 99th percentile, nanoseconds
+ * - fairness     Jain's index over per-thread acquisition counts:
+ *                (sum x)^2 / (n * sum x^2). 1.0 = every thread got the
+ *                same share; 1/n = one thread got everything
+ *
+ * Results print as a table and are written as <prefix>.csv and
+ * <prefix>.json; scripts/lock_fairness/main.py charts the CSV.
+ *
+ * Linux only (futex for AdaptiveMutex).
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread lock_benchmark.cpp
+ * Run:     ./a.out [output prefix] [ms per run]   (default lock_benchmark, 100)
+ */
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─── Locks ───────────────────────────────────────────────────────────────────
+
+// lock()/unlock() only; see spinlock_family.cpp and adaptive_mutex.cpp for
+// the design notes and the try_lock() variants.
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#endif
+}
+
+inline void spin_wait(unsigned& spins) {
+    if (++spins % 128 == 0) {
+        std::this_thread::yield();
+    } else {
+        cpu_relax();
+    }
+}
+
+class Spinlock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            cpu_relax();
+        }
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+class TTASLock {
+public:
+    void lock() noexcept {
+        unsigned backoff = 1;
+        unsigned spins = 0;
+        while (true) {
+            while (locked_.load(std::memory_order_relaxed)) spin_wait(spins);
+            if (!locked_.exchange(true, std::memory_order_acquire)) return;
+
+            for (unsigned i = 0; i < backoff; ++i) cpu_relax();
+            if (backoff < kMaxBackoff) backoff <<= 1;
+        }
+    }
+
+    void unlock() noexcept {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+    static constexpr unsigned kMaxBackoff = 1024;
+    std::atomic<bool> locked_{false};
+};
+
+class TicketLock {
+public:
+    void lock() noexcept {
+        uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        unsigned spins = 0;
+        while (serving_.load(std::memory_order_acquire) != ticket) spin_wait(spins);
+    }
+
+    void unlock() noexcept {
+        serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<uint32_t> next_{0};
+    alignas(64) std::atomic<uint32_t> serving_{0};
+};
+
+template <typename Node>
+class NodeCache {
+public:
+    static Node* take() {
+        auto& spares = instance().spares_;
+        if (spares.empty()) return new Node;
+        Node* node = spares.back();
+        spares.pop_back();
+        return node;
+    }
+
+    static void give(Node* node) { instance().spares_.push_back(node); }
+
+private:
+    ~NodeCache() {
+        for (Node* node : spares_) delete node;
+    }
+
+    static NodeCache& instance() {
+        thread_local NodeCache cache;
+        return cache;
+    }
+
+    std::vector<Node*> spares_;
+};
+
+class MCSLock {
+public:
+    void lock() noexcept {
+        QNode* node = NodeCache<QNode>::take();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+
+        QNode* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        if (pred) {
+            pred->next.store(node, std::memory_order_release);
+            unsigned spins = 0;
+            while (node->locked.load(std::memory_order_acquire)) spin_wait(spins);
+        }
+        holder_ = node;
+    }
+
+    void unlock() noexcept {
+        QNode* node = holder_;
+        QNode* succ = node->next.load(std::memory_order_acquire);
+        if (!succ) {
+            QNode* expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                NodeCache<QNode>::give(node);
+                return;
+            }
+            unsigned spins = 0;
+            while (!(succ = node->next.load(std::memory_order_acquire))) spin_wait(spins);
+        }
+        succ->locked.store(false, std::memory_order_release);
+        NodeCache<QNode>::give(node);
+    }
+
+private:
+    struct alignas(64) QNode {
+        std::atomic<QNode*> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(64) std::atomic<QNode*> tail_{nullptr};
+    QNode* holder_ = nullptr;
+};
+
+class CLHLock {
+public:
+    CLHLock() : tail_(new QNode) {}
+    ~CLHLock() { delete tail_.load(); }
+
+    CLHLock(const CLHLock&) = delete;
+    CLHLock& operator=(const CLHLock&) = delete;
+
+    void lock() noexcept {
+        QNode* node = NodeCache<QNode>::take();
+        node->locked.store(true, std::memory_order_relaxed);
+        QNode* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        unsigned spins = 0;
+        while (pred->locked.load(std::memory_order_acquire)) spin_wait(spins);
+        holder_ = node;
+        holder_pred_ = pred;
+    }
+
+    void unlock() noexcept {
+        QNode* node = holder_;
+        QNode* pred = holder_pred_;
+        node->locked.store(false, std::memory_order_release);
+        NodeCache<QNode>::give(pred);
+    }
+
+private:
+    struct alignas(64) QNode {
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(64) std::atomic<QNode*> tail_;
+    QNode* holder_ = nullptr;
+    QNode* holder_pred_ = nullptr;
+};
+
+inline void futex_wait(std::atomic<int>& word, int expected) {
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake_one(std::atomic<int>& word) {
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+constexpr double kSpinBudgetNs = 4000;
+
+int calibrate_spin_limit() {
+    if (std::thread::hardware_concurrency() <= 1) return 0;
+
+    constexpr int kPauses = 20'000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPauses; ++i) cpu_relax();
+    double ns_per_pause = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / kPauses;
+    return static_cast<int>(std::clamp(kSpinBudgetNs / std::max(ns_per_pause, 0.1), 16.0, 100'000.0));
+}
+
+const int g_spin_limit = calibrate_spin_limit();
+
+class AdaptiveMutex {
+public:
+    void lock() noexcept {
+        int expected = 0;
+        if (state_.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+            return;
+        }
+        if (!spin_then_try()) sleep_until_acquired();
+    }
+
+    void unlock() noexcept {
+        if (state_.exchange(0, std::memory_order_release) == 2) {
+            futex_wake_one(state_);
+        }
+    }
+
+private:
+    bool spin_then_try() noexcept {
+        int avg = spin_avg_.load(std::memory_order_relaxed);
+        int limit = std::min(g_spin_limit, 2 * avg + 16);
+        for (int i = 0; i < limit; ++i) {
+            if (state_.load(std::memory_order_relaxed) == 0) {
+                int expected = 0;
+                if (state_.compare_exchange_weak(expected, 1, std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+                    spin_avg_.store(avg + (i - avg) / 8, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            cpu_relax();
+        }
+        spin_avg_.store(avg - avg / 8, std::memory_order_relaxed);
+        return false;
+    }
+
+    void sleep_until_acquired() noexcept {
+        while (state_.exchange(2, std::memory_order_acquire) != 0) {
+            futex_wait(state_, 2);
+        }
+    }
+
+    std::atomic<int> state_{0};
+    std::atomic<int> spin_avg_{g_spin_limit / 2};
+};
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+using Clock = std::chrono::steady_clock;
+
+// A dependent chain of `n` multiply-adds: a few ns each, not optimisable away.
+inline void work(int n, uint64_t& x) {
+    for (int i = 0; i < n; ++i) x = x * 6364136223846793005ull + 1442695040888963407ull;
+}
+
+struct Config {
+    int threads;
+    int cs_work;
+    int noncs_work;
+};
+
+struct Result {
+    std::string lock;
+    Config config;
+    uint64_t acquisitions;
+    double throughput;
+    double p50_ns;
+    double p99_ns;
+    double fairness;
+    uint64_t min_count;
+    uint64_t max_count;
+};
+
+struct alignas(64) PerThread {
+    uint64_t count = 0;
+    std::vector<float> acquire_ns;
+    uint64_t sink = 0;
+};
+
+double jain_index(const std::vector<PerThread>& stats) {
+    double sum = 0, sum_sq = 0;
+    for (const auto& s : stats) {
+        sum += static_cast<double>(s.count);
+        sum_sq += static_cast<double>(s.count) * static_cast<double>(s.count);
+    }
+    return sum_sq == 0 ? 0.0 : sum * sum / (stats.size() * sum_sq);
+}
+
+template <typename Lock>
+Result run_config(const char* name, const Config& cfg, std::chrono::milliseconds duration) {
+    Lock lock;
+    uint64_t shared_counter = 0;  // protected by lock
+    std::vector<PerThread> stats(cfg.threads);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false}, stop{false};
+
+    std::vector<std::thread> threads;
+    threads.reserve(cfg.threads);
+    for (int t = 0; t < cfg.threads; ++t) {
+        threads.emplace_back([&, t] {
+            PerThread& me = stats[t];
+            me.acquire_ns.reserve(1 << 16);
+            uint64_t x = t + 1;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto before = Clock::now();
+                lock.lock();
+                auto acquired = Clock::now();
+                ++shared_counter;
+                work(cfg.cs_work, x);
+                lock.unlock();
+
+                me.acquire_ns.push_back(std::chrono::duration<float, std::nano>(acquired - before).count());
+                ++me.count;
+                work(cfg.noncs_work, x);
+            }
+            me.sink = x;
+        });
+    }
+
+    while (ready.load() < cfg.threads) std::this_thread::yield();
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true, std::memory_order_relaxed);
+    auto stopped = Clock::now();
+    for (auto& th : threads) th.join();
+
+    std::vector<float> all;
+    uint64_t total = 0, min_count = UINT64_MAX, max_count = 0;
+    for (auto& s : stats) {
+        total += s.count;
+        min_count = std::min(min_count, s.count);
+        max_count = std::max(max_count, s.count);
+        all.insert(all.end(), s.acquire_ns.begin(), s.acquire_ns.end());
+    }
+    if (total != shared_counter) std::cerr << name << ": WRONG COUNT (lock is broken)\n";
+
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double q) {
+        return all.empty() ? 0.0 : all[static_cast<std::size_t>(q * (all.size() - 1))];
+    };
+    // Threads finish their current iteration after stop; count them anyway,
+    // the overrun is at most one iteration per thread.
+    double secs = std::chrono::duration<double>(stopped - start).count();
+    return {name, cfg, total, total / secs, pct(0.50), pct(0.99), jain_index(stats), min_count, max_count};
+}
+
+// ─── Output ──────────────────────────────────────────────────────────────────
+
+std::string to_csv(const std::vector<Result>& results) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+    out << "lock,threads,cs_work,noncs_work,acquisitions,throughput_per_sec,p50_ns,p99_ns,"
+           "fairness,min_count,max_count\n";
+    for (const Result& r : results) {
+        out << r.lock << "," << r.config.threads << "," << r.config.cs_work << ","
+            << r.config.noncs_work << "," << r.acquisitions << "," << r.throughput << ","
+            << r.p50_ns << "," << r.p99_ns << "," << r.fairness << "," << r.min_count << ","
+            << r.max_count << "\n";
+    }
+    return out.str();
+}
+
+std::string to_json(const std::vector<Result>& results) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4) << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "  {\"lock\": \"" << r.lock << "\", \"threads\": " << r.config.threads
+            << ", \"cs_work\": " << r.config.cs_work << ", \"noncs_work\": " << r.config.noncs_work
+            << ", \"acquisitions\": " << r.acquisitions << ", \"throughput_per_sec\": " << r.throughput
+            << ", \"acquire_ns\": {\"p50\": " << r.p50_ns << ", \"p99\": " << r.p99_ns << "}"
+            << ", \"fairness\": " << r.fairness << ", \"min_count\": " << r.min_count
+            << ", \"max_count\": " << r.max_count << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+    return out.str();
+}
+
+void print_row(const Result& r) {
+    std::cout << std::left << std::setw(16) << r.lock << std::right << std::setw(5) << r.config.threads
+              << std::setw(6) << r.config.cs_work << std::setw(7) << r.config.noncs_work << std::fixed
+              << std::setprecision(0) << std::setw(13) << r.throughput << std::setw(10) << r.p50_ns
+              << std::setw(11) << r.p99_ns << std::setprecision(3) << std::setw(9) << r.fairness << "\n";
+}
+
+// ─── Sweep ───────────────────────────────────────────────────────────────────
+
+template <typename Lock>
+void sweep(const char* name, const std::vector<int>& thread_counts, std::chrono::milliseconds duration,
+           std::vector<Result>& results) {
+    for (int threads : thread_counts) {
+        for (int cs : {0, 50, 500}) {
+            for (int noncs : {0, 500, 5000}) {
+                Result r = run_config<Lock>(name, {threads, cs, noncs}, duration);
+                print_row(r);
+                results.push_back(std::move(r));
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string prefix = argc > 1 ? argv[1] : "lock_benchmark";
+    std::chrono::milliseconds duration(argc > 2 ? std::stoi(argv[2]) : 100);
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores == 0) cores = 2;
+    // 1, 2, 4, ... up to the core count, then oversubscribed at 2x cores.
+    std::vector<int> thread_counts;
+    for (int n = 1; n < cores; n *= 2) thread_counts.push_back(n);
+    thread_counts.push_back(cores);
+    thread_counts.push_back(2 * cores);
+
+    std::cout << "Cores: " << cores << ", " << duration.count() << " ms per run\n\n";
+    std::cout << std::left << std::setw(16) << "lock" << std::right << std::setw(5) << "thr"
+              << std::setw(6) << "cs" << std::setw(7) << "noncs" << std::setw(13) << "acq/s"
+              << std::setw(10) << "p50 ns" << std::setw(11) << "p99 ns" << std::setw(9) << "jain\n";
+
+    std::vector<Result> results;
+    sweep<std::mutex>("std::mutex", thread_counts, duration, results);
+    sweep<std::recursive_mutex>("recursive_mutex", thread_counts, duration, results);
+    sweep<std::timed_mutex>("timed_mutex", thread_counts, duration, results);
+    sweep<std::shared_mutex>("shared_mutex", thread_counts, duration, results);
+    sweep<Spinlock>("Spinlock", thread_counts, duration, results);
+    sweep<TTASLock>("TTASLock", thread_counts, duration, results);
+    sweep<TicketLock>("TicketLock", thread_counts, duration, results);
+    sweep<MCSLock>("MCSLock", thread_counts, duration, results);
+    sweep<CLHLock>("CLHLock", thread_counts, duration, results);
+    sweep<AdaptiveMutex>("AdaptiveMutex", thread_counts, duration, results);
+
+    std::ofstream(prefix + ".csv") << to_csv(results);
+    std::ofstream(prefix + ".json") << to_json(results);
+    std::cout << "\nWrote " << results.size() << " results to " << prefix << ".csv and " << prefix
+              << ".json\n";
+    return 0;
+}
@@ -0,0 +1,396 @@
+/**
+ * NUMA-Aware Thread Pool with CPU Affinity
+ *
+ * On multi-socket machines each socket (NUMA node) has its own memory
+ * controller. Memory attached to another socket is reachable but slower,
+ * and the OS is free to migrate ThreadPool workers (thread_pool.cpp) from
+ * one socket to the other. Tasks that touch node-local data then end up
+ * running far away from it.
+ *
+ * This example adds three pieces:
+ * - Topology: reads /sys/devices/system/cpu and /sys/devices/system/node to
+ *   find which CPUs belong to which node, restricted to the CPUs this
+ *   process is allowed to run on (sched_getaffinity, cgroups, taskset)
+ * - Worker placement: each worker is assigned to a node and optionally
+ *   pinned to one CPU with pthread_setaffinity_np
+ * - Queue shards: one queue per node. enqueue()/submit() take an optional
+ *   node hint so tasks run on workers close to the data they touch.
+ *   Workers drain their own node's shard first and only then help others.
+ *   Idle workers block on their shard's condition variable; enqueue wakes
+ *   a sleeper on the task's node, or on any other node if none is asleep
+ *   there, so no worker polls.
+ *
+ * On machines without /sys/devices/system/node (or with a single node)
+ * everything collapses to one shard holding every allowed CPU, which
+ * behaves like the plain ThreadPool.
+ *
+ * Linux only: uses sched_getaffinity, pthread_setaffinity_np, sched_getcpu.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread numa_thread_pool.cpp
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// ─── Topology ────────────────────────────────────────────────────────────────
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+class Topology {
+public:
+    // Parse the kernel's cpulist format, e.g. "0-3,8,10-11". Node lists
+    // (/sys/devices/system/node/online) use the same format.
+    static std::vector<int> parse_cpulist(const std::string& text) {
+        std::vector<int> cpus;
+        std::stringstream ss(text);
+        std::string part;
+        while (std::getline(ss, part, ',')) {
+            if (part.empty() || part == "\n") continue;
+            auto dash = part.find('-');
+            try {
+                int lo = std::stoi(part.substr(0, dash));
+                int hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+                for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+            } catch (const std::exception&) {
+                // Malformed entry: ignore it rather than fail the whole pool.
+            }
+        }
+        return cpus;
+    }
+
+    static Topology detect() {
+        Topology topo;
+        std::vector<int> allowed = allowed_cpus();
+
+        // Node ids can be sparse (e.g. "0,2" or "0-1,8"), so list them from
+        // the kernel instead of probing node0, node1, ...
+        std::vector<int> online;
+        {
+            std::ifstream in("/sys/devices/system/node/online");
+            std::string line;
+            if (in && std::getline(in, line)) online = parse_cpulist(line);
+        }
+
+        for (int node : online) {
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!in) continue;
+            std::string line;
+            std::getline(in, line);
+            NumaNode n{node, {}};
+            for (int cpu : parse_cpulist(line)) {
+                if (contains(allowed, cpu)) n.cpus.push_back(cpu);
+            }
+            if (!n.cpus.empty()) topo.nodes_.push_back(std::move(n));
+        }
+
+        // No NUMA information (non-NUMA kernel, containers, other OS):
+        // one node holding every allowed CPU.
+        if (topo.nodes_.empty()) {
+            topo.nodes_.push_back({0, allowed});
+        }
+        return topo;
+    }
+
+    size_t node_count() const { return nodes_.size(); }
+    const std::vector<NumaNode>& nodes() const { return nodes_; }
+
+    size_t cpu_count() const {
+        size_t n = 0;
+        for (const auto& node : nodes_) n += node.cpus.size();
+        return n;
+    }
+
+private:
+    static bool contains(const std::vector<int>& v, int x) {
+        for (int y : v) if (y == x) return true;
+        return false;
+    }
+
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; ++c) {
+                if (CPU_ISSET(c, &set)) cpus.push_back(c);
+            }
+        }
+        if (cpus.empty()) {
+            std::ifstream in("/sys/devices/system/cpu/online");
+            std::string line;
+            if (in && std::getline(in, line)) cpus = parse_cpulist(line);
+        }
+        if (cpus.empty()) {
+            unsigned int hw = std::thread::hardware_concurrency();
+            cpus.resize(hw == 0 ? 1 : hw);
+            std::iota(cpus.begin(), cpus.end(), 0);
+        }
+        return cpus;
+    }
+
+    std::vector<NumaNode> nodes_;
+};
+
+// ─── NUMA-aware pool ─────────────────────────────────────────────────────────
+
+struct NumaPoolOptions {
+    bool pin_workers = true;     // pin each worker to a single CPU
+    bool shard_per_node = true;  // one queue per node instead of one global queue
+};
+
+class NumaThreadPool {
+public:
+    static constexpr int kAnyNode = -1;
+
+    NumaThreadPool(size_t num_threads, const Topology& topo,
+                   NumaPoolOptions options = {})
+        : topo_(topo), options_(options) {
+        size_t shards = options_.shard_per_node ? topo_.node_count() : 1;
+        for (size_t s = 0; s < shards; ++s) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+
+        // Spread workers round-robin across nodes, then across each node's
+        // CPUs, so every node gets a worker before any node gets a second.
+        std::vector<size_t> next_cpu(topo_.node_count(), 0);
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            size_t node = i % topo_.node_count();
+            const auto& cpus = topo_.nodes()[node].cpus;
+            int cpu = cpus[next_cpu[node]++ % cpus.size()];
+            size_t shard = options_.shard_per_node ? node : 0;
+            workers_.emplace_back(&NumaThreadPool::worker_loop, this, shard, node, cpu);
+        }
+    }
+
+    ~NumaThreadPool() {
+        stop_.store(true);
+        for (auto& shard : shards_) {
+            { std::scoped_lock lock(shard->mutex); }
+            shard->cv.notify_all();
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    NumaThreadPool(const NumaThreadPool&) = delete;
+    NumaThreadPool& operator=(const NumaThreadPool&) = delete;
+
+    // node_hint is an index into Topology::nodes(); kAnyNode spreads tasks
+    // round-robin across shards.
+    void enqueue(std::function<void()> task, int node_hint = kAnyNode) {
+        size_t home = shard_for(node_hint);
+        Shard& shard = *shards_[home];
+        {
+            std::scoped_lock lock(shard.mutex);
+            if (stop_.load())
+                throw std::runtime_error("enqueue() called on a stopped NumaThreadPool");
+            shard.tasks.push(std::move(task));
+            queued_.fetch_add(1);
+        }
+        wake_one(home);
+    }
+
+    template <typename F, typename... Args>
+    auto submit(int node_hint, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+        std::future<ReturnType> fut = task->get_future();
+        enqueue([task]() { (*task)(); }, node_hint);
+        return fut;
+    }
+
+    size_t node_count() const { return topo_.node_count(); }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<std::function<void()>> tasks;
+        std::atomic<int> sleepers{0};  // workers blocked on cv
+    };
+
+    size_t shard_for(int node_hint) {
+        if (shards_.size() == 1) return 0;
+        if (node_hint < 0) {
+            return round_robin_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+        }
+        return static_cast<size_t>(node_hint) % shards_.size();
+    }
+
+    static void place_thread(const std::vector<int>& cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) CPU_SET(c, &set);
+        // Failure (e.g. CPU went offline) just leaves the thread unpinned.
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    // Called after queued_ was incremented. Prefer a sleeper on the task's
+    // own node; otherwise any sleeper can take it from a remote shard.
+    // Locking the shard's mutex before notifying means a worker that has
+    // registered as a sleeper is either already waiting or will still see
+    // queued_ > 0 in its predicate.
+    void wake_one(size_t home) {
+        for (size_t k = 0; k < shards_.size(); ++k) {
+            Shard& s = *shards_[(home + k) % shards_.size()];
+            if (s.sleepers.load() > 0) {
+                { std::scoped_lock lock(s.mutex); }
+                s.cv.notify_one();
+                return;
+            }
+        }
+    }
+
+    bool try_pop(Shard& shard, std::function<void()>& task) {
+        std::scoped_lock lock(shard.mutex);
+        if (shard.tasks.empty()) return false;
+        task = std::move(shard.tasks.front());
+        shard.tasks.pop();
+        queued_.fetch_sub(1);
+        return true;
+    }
+
+    // Remote shards are only checked after the local one is empty, so
+    // node-local work is always preferred but no shard is ever stranded.
+    bool try_pop_remote(size_t home, std::function<void()>& task) {
+        for (size_t k = 1; k < shards_.size(); ++k) {
+            if (try_pop(*shards_[(home + k) % shards_.size()], task)) return true;
+        }
+        return false;
+    }
+
+    void worker_loop(size_t home, size_t node, int cpu) {
+        if (options_.pin_workers) {
+            place_thread({cpu});
+        } else if (topo_.node_count() > 1) {
+            place_thread(topo_.nodes()[node].cpus);  // stay on the node
+        }
+
+        Shard& shard = *shards_[home];
+        std::function<void()> task;
+        while (true) {
+            if (try_pop(shard, task) || try_pop_remote(home, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            // Register before checking queued_ (both seq_cst): either
+            // enqueue sees this sleeper and notifies, or the predicate sees
+            // its task, wherever it was queued.
+            shard.sleepers.fetch_add(1);
+            shard.cv.wait(lock, [&] {
+                return stop_.load() || queued_.load() > 0;
+            });
+            shard.sleepers.fetch_sub(1);
+            if (stop_.load() && queued_.load() == 0) return;
+        }
+    }
+
+    Topology topo_;
+    NumaPoolOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> round_robin_{0};
+    std::atomic<long> queued_{0};
+    std::atomic<bool> stop_{false};
+};
+
+// ─── Demo / benchmark ────────────────────────────────────────────────────────
+
+constexpr size_t kElementsPerNode = 8 * 1024 * 1024;  // 64 MB of longs per node
+constexpr int kPasses = 5;
+
+int main() {
+    Topology topo = Topology::detect();
+
+    std::cout << "=== Topology: " << topo.node_count() << " node(s), "
+              << topo.cpu_count() << " allowed CPU(s) ===\n";
+    for (const auto& node : topo.nodes()) {
+        std::cout << "  node " << node.id << ": cpus";
+        for (int c : node.cpus) std::cout << " " << c;
+        std::cout << "\n";
+    }
+
+    NumaThreadPool pool(topo.cpu_count(), topo);
+
+    // Show where hinted tasks actually run.
+    std::cout << "\nTask placement (node hint -> cpu):\n";
+    for (int node = 0; node < static_cast<int>(topo.node_count()); ++node) {
+        int cpu = pool.submit(node, [] { return sched_getcpu(); }).get();
+        std::cout << "  hint " << node << " -> cpu " << cpu << "\n";
+    }
+
+    // First-touch policy: pages are placed on the node of the thread that
+    // first writes them, so initialise each node's buffer from that node.
+    std::vector<std::vector<long>> data(topo.node_count());
+    {
+        std::vector<std::future<void>> init;
+        for (int node = 0; node < static_cast<int>(topo.node_count()); ++node) {
+            init.push_back(pool.submit(node, [&data, node] {
+                data[node].assign(kElementsPerNode, 1);
+            }));
+        }
+        for (auto& f : init) f.get();
+    }
+
+    auto run = [&](bool local) {
+        auto start = std::chrono::high_resolution_clock::now();
+        long total = 0;
+        for (int pass = 0; pass < kPasses; ++pass) {
+            std::vector<std::future<long>> sums;
+            for (int node = 0; node < static_cast<int>(topo.node_count()); ++node) {
+                int hint = local ? node : (node + 1) % static_cast<int>(topo.node_count());
+                sums.push_back(pool.submit(hint, [&data, node] {
+                    return std::accumulate(data[node].begin(), data[node].end(), 0L);
+                }));
+            }
+            for (auto& s : sums) total += s.get();
+        }
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        return std::make_pair(total, ms);
+    };
+
+    auto [local_sum, local_ms] = run(true);
+    auto [remote_sum, remote_ms] = run(false);
+
+    std::cout << "\nSumming node-local buffers (" << kPasses << " passes):\n";
+    std::cout << "  tasks on the data's node:   " << local_ms << " ms (sum " << local_sum << ")\n";
+    std::cout << "  tasks on a different node:  " << remote_ms << " ms (sum " << remote_sum << ")\n";
+    if (topo.node_count() == 1) {
+        std::cout << "\nNote: single-node machine, so both runs are local and\n"
+                  << "should take about the same time.\n";
+    }
+    return 0;
+}
@@ -0,0 +1,470 @@
+/**
+ * parallel_for / parallel_reduce on a Persistent Thread Pool
+ *
+ * parallel_multiply (matrix_multiply.cpp) and compute_sum (raw_pthread.cpp)
+ * both split their range into one equal chunk per thread and start fresh
+ * threads on every call. That has two costs:
+ * - thread creation on every call, even for small inputs
+ * - static chunks: if some iterations are more expensive than others (a
+ *   triangular matrix, data-dependent work), one thread gets the heavy end
+ *   and everybody else waits for it
+ *
+ * This example provides loop-parallel algorithms that run on one persistent
+ * pool and let the caller choose how the range is partitioned:
+ *
+ *   StaticPartitioner   one precomputed contiguous range per participant
+ *                       (the old behaviour)
+ *   DynamicPartitioner  fixed-size chunks handed out on demand
+ *   GuidedPartitioner   chunks start large and shrink as work runs out
+ *                       (remaining / (2 * participants), OpenMP-style)
+ *   AutoPartitioner     each participant times its chunks and resizes its
+ *                       grain towards a target chunk duration, so cheap
+ *                       iterations are batched and expensive ones are not
+ *
+ * The calling thread always takes part in the loop. Helpers that start
+ * after the work is gone just return, so parallel_for can be called from
+ * inside a pool task without deadlocking on busy workers.
+ *
+ * parallel_reduce folds every chunk into its own partial and combines the
+ * partials in index order, so combine only has to be associative, not
+ * commutative. Static and dynamic chunk boundaries don't depend on timing,
+ * so their floating-point results are the same on every run; guided and
+ * auto boundaries do, so there only the grouping can change.
+ *
+ * Both examples are ported and benchmarked against the current static
+ * splits on imbalanced workloads.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread parallel_for.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ─── Persistent pool (same design as thread_pool.cpp) ────────────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// One pool for the whole program, started on first use. The caller also
+// participates, so hardware_concurrency - 1 workers fill the machine.
+ThreadPool& default_pool() {
+    static ThreadPool pool([] {
+        unsigned int hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 1;
+    }());
+    return pool;
+}
+
+// ─── Ranges and partitioners ─────────────────────────────────────────────────
+
+struct Range {
+    size_t begin;
+    size_t end;
+    size_t size() const { return end > begin ? end - begin : 0; }
+};
+
+struct StaticPartitioner {};
+
+struct DynamicPartitioner {
+    size_t grain = 64;
+};
+
+struct GuidedPartitioner {
+    size_t min_grain = 1;
+};
+
+struct AutoPartitioner {
+    std::chrono::microseconds target_chunk{50};
+};
+
+// Hands out [lo, hi) chunks to participants. One instance per loop.
+class ChunkSource {
+public:
+    ChunkSource(Range r, size_t participants)
+        : range_(r), participants_(participants), next_(r.begin),
+          slot_taken_(new std::atomic<bool>[participants]) {
+        for (size_t s = 0; s < participants; ++s) slot_taken_[s].store(false, std::memory_order_relaxed);
+    }
+
+    // Static split: slot s is [begin + n*s/P, begin + n*(s+1)/P), handed out
+    // at most once.
+    bool claim_slot(size_t slot, size_t& lo, size_t& hi) {
+        if (slot_taken_[slot].exchange(true, std::memory_order_relaxed)) return false;
+        size_t n = range_.size();
+        lo = range_.begin + n * slot / participants_;
+        hi = range_.begin + n * (slot + 1) / participants_;
+        return true;
+    }
+
+    bool claim(size_t grain, size_t& lo, size_t& hi) {
+        lo = next_.fetch_add(grain, std::memory_order_relaxed);
+        if (lo >= range_.end) return false;
+        hi = std::min(lo + grain, range_.end);
+        return true;
+    }
+
+    bool claim_guided(size_t min_grain, size_t& lo, size_t& hi) {
+        size_t cur = next_.load(std::memory_order_relaxed);
+        while (cur < range_.end) {
+            size_t remaining = range_.end - cur;
+            size_t grain = std::max(min_grain, remaining / (2 * participants_));
+            size_t end = std::min(cur + grain, range_.end);
+            if (next_.compare_exchange_weak(cur, end, std::memory_order_relaxed)) {
+                lo = cur;
+                hi = end;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Range& range() const { return range_; }
+    size_t participants() const { return participants_; }
+
+private:
+    Range range_;
+    size_t participants_;
+    std::atomic<size_t> next_;
+    std::unique_ptr<std::atomic<bool>[]> slot_taken_;
+};
+
+// Run chunk(lo, hi) over every chunk the partitioner hands to participant id.
+// Participant id runs slot id. Helpers that never start (busy pool) leave
+// their slot unclaimed, so whoever finishes first picks those up.
+template <typename Chunk>
+void drain(ChunkSource& src, size_t id, StaticPartitioner, Chunk&& chunk) {
+    size_t lo, hi;
+    if (src.claim_slot(id, lo, hi)) chunk(lo, hi);
+    for (size_t s = 0; s < src.participants(); ++s) {
+        if (src.claim_slot(s, lo, hi)) chunk(lo, hi);
+    }
+}
+
+template <typename Chunk>
+void drain(ChunkSource& src, size_t, DynamicPartitioner p, Chunk&& chunk) {
+    size_t lo, hi;
+    while (src.claim(std::max<size_t>(p.grain, 1), lo, hi)) chunk(lo, hi);
+}
+
+template <typename Chunk>
+void drain(ChunkSource& src, size_t, GuidedPartitioner p, Chunk&& chunk) {
+    size_t lo, hi;
+    while (src.claim_guided(std::max<size_t>(p.min_grain, 1), lo, hi)) chunk(lo, hi);
+}
+
+template <typename Chunk>
+void drain(ChunkSource& src, size_t, AutoPartitioner p, Chunk&& chunk) {
+    using Clock = std::chrono::steady_clock;
+    const double target_ns = std::chrono::duration<double, std::nano>(p.target_chunk).count();
+    const size_t max_grain = std::max<size_t>(1, src.range().size() / (4 * src.participants()));
+    size_t grain = 1;
+    size_t lo, hi;
+    while (src.claim(grain, lo, hi)) {
+        auto start = Clock::now();
+        chunk(lo, hi);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        // Move towards the target, but at most 2x per step to damp noise.
+        double scale = ns > 0 ? std::clamp(target_ns / ns, 0.5, 2.0) : 2.0;
+        grain = std::clamp<size_t>(static_cast<size_t>(grain * scale), 1, max_grain);
+    }
+}
+
+// Run participant(id) on the caller and on up to pool-size helpers, and
+// return when all participants that actually started have finished.
+template <typename Participant>
+void run_participants(ThreadPool& pool, size_t helpers, Participant&& participant) {
+    struct Join {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t active = 0;
+        bool closed = false;
+    };
+    auto join = std::make_shared<Join>();
+
+    for (size_t h = 0; h < helpers; ++h) {
+        pool.enqueue([join, &participant, id = h + 1] {
+            {
+                std::scoped_lock lock(join->mutex);
+                if (join->closed) return;  // caller already finished the loop
+                ++join->active;
+            }
+            participant(id);
+            {
+                std::scoped_lock lock(join->mutex);
+                --join->active;
+            }
+            join->cv.notify_all();
+        });
+    }
+
+    participant(0);
+
+    std::unique_lock<std::mutex> lock(join->mutex);
+    join->closed = true;
+    join->cv.wait(lock, [&] { return join->active == 0; });
+}
+
+// ─── parallel_for / parallel_reduce ──────────────────────────────────────────
+
+template <typename Body, typename Partitioner = AutoPartitioner>
+void parallel_for(Range range, Body&& body, Partitioner partitioner = {},
+                  ThreadPool& pool = default_pool()) {
+    if (range.size() == 0) return;
+    size_t participants = std::min(range.size(), pool.thread_count() + 1);
+    ChunkSource src(range, participants);
+
+    run_participants(pool, participants - 1, [&](size_t id) {
+        drain(src, id, partitioner, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) body(i);
+        });
+    });
+}
+
+// fold(acc, i) accumulates one index; combine(a, b) merges partial results.
+// Each chunk gets its own partial, keyed by its first index; the partials
+// are combined left to right once the loop is done.
+template <typename T, typename Fold, typename Combine, typename Partitioner = AutoPartitioner>
+T parallel_reduce(Range range, T identity, Fold&& fold, Combine&& combine,
+                  Partitioner partitioner = {}, ThreadPool& pool = default_pool()) {
+    if (range.size() == 0) return identity;
+    size_t participants = std::min(range.size(), pool.thread_count() + 1);
+    ChunkSource src(range, participants);
+
+    // One list per participant, so recording a partial takes no lock.
+    std::vector<std::vector<std::pair<size_t, T>>> partials(participants);
+
+    run_participants(pool, participants - 1, [&](size_t id) {
+        drain(src, id, partitioner, [&](size_t lo, size_t hi) {
+            T local = identity;
+            for (size_t i = lo; i < hi; ++i) local = fold(std::move(local), i);
+            partials[id].emplace_back(lo, std::move(local));
+        });
+    });
+
+    std::vector<std::pair<size_t, T>> chunks;
+    for (auto& list : partials) {
+        for (auto& chunk : list) chunks.push_back(std::move(chunk));
+    }
+    std::sort(chunks.begin(), chunks.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    T result = std::move(identity);
+    for (auto& chunk : chunks) result = combine(std::move(result), std::move(chunk.second));
+    return result;
+}
+
+// ─── Port 1: parallel_multiply (matrix_multiply.cpp) ─────────────────────────
+
+using Matrix = std::vector<std::vector<long>>;
+
+// Lower-triangular product: row i costs O(i * n), so the last rows are far
+// more expensive than the first ones. A static split gives the last thread
+// almost half of the total work.
+void triangular_row(const Matrix& A, const Matrix& B, Matrix& C, size_t i) {
+    size_t inner = A[0].size();
+    for (size_t j = 0; j <= i; ++j) {
+        long sum = 0;
+        for (size_t k = 0; k < inner; ++k) sum += A[i][k] * B[k][j];
+        C[i][j] = sum;
+    }
+}
+
+// The old way: one fresh std::thread per core, equal row chunks.
+void static_threads_multiply(const Matrix& A, const Matrix& B, Matrix& C) {
+    unsigned int num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 2;
+
+    size_t rows = A.size();
+    size_t chunk_size = static_cast<size_t>(std::ceil(static_cast<double>(rows) / num_threads));
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; ++t) {
+        size_t start = std::min(t * chunk_size, rows);
+        size_t end = std::min((t + 1) * chunk_size, rows);
+        if (start < end) {
+            workers.emplace_back([&, start, end] {
+                for (size_t i = start; i < end; ++i) triangular_row(A, B, C, i);
+            });
+        }
+    }
+    for (auto& w : workers) w.join();
+}
+
+template <typename Partitioner>
+void parallel_multiply(const Matrix& A, const Matrix& B, Matrix& C, Partitioner p) {
+    parallel_for({0, A.size()}, [&](size_t i) { triangular_row(A, B, C, i); }, p);
+}
+
+// ─── Port 2: compute_sum (raw_pthread.cpp) ───────────────────────────────────
+
+// Imbalanced per-element cost: element i does i / 8 units of work, so the
+// last chunk of a static split is the most expensive one.
+long long weighted_value(long long i) {
+    long long acc = i;
+    for (long long k = 0; k < i / 8; ++k) acc = (acc * 31 + k) % 1000003;
+    return acc;
+}
+
+// The old way: one fresh thread per equal chunk, partial sums combined at the end.
+long long static_threads_sum(long long range_end, int num_threads) {
+    std::vector<long long> partial(num_threads, 0);
+    std::vector<std::thread> threads;
+    long long chunk = range_end / num_threads;
+    for (int t = 0; t < num_threads; ++t) {
+        long long lo = chunk * t;
+        long long hi = t == num_threads - 1 ? range_end : chunk * (t + 1);
+        threads.emplace_back([&partial, t, lo, hi] {
+            for (long long i = lo; i < hi; ++i) partial[t] += weighted_value(i);
+        });
+    }
+    for (auto& th : threads) th.join();
+    long long total = 0;
+    for (long long p : partial) total += p;
+    return total;
+}
+
+template <typename Partitioner>
+long long compute_sum(long long range_end, Partitioner p) {
+    return parallel_reduce(
+        {0, static_cast<size_t>(range_end)}, 0LL,
+        [](long long acc, size_t i) { return acc + weighted_value(static_cast<long long>(i)); },
+        [](long long a, long long b) { return a + b; }, p);
+}
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+template <typename F>
+double time_ms(F&& f, int runs = 3) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+void row(const char* name, double ms, double baseline) {
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(9) << ms << " ms"
+              << std::setw(8) << std::setprecision(2) << baseline / ms << "x\n";
+}
+
+int main() {
+    unsigned int hw = std::thread::hardware_concurrency();
+    std::cout << "Hardware threads: " << (hw ? hw : 2) << "\n";
+
+    // ── Triangular matrix multiply ────────────────────────────────────
+    constexpr size_t N = 400;
+    Matrix A(N, std::vector<long>(N)), B(N, std::vector<long>(N));
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = 0; j < N; ++j) {
+            A[i][j] = static_cast<long>((i + j) % 7);
+            B[i][j] = static_cast<long>((i * j) % 5);
+        }
+    Matrix expected(N, std::vector<long>(N, 0)), C(N, std::vector<long>(N, 0));
+    static_threads_multiply(A, B, expected);
+
+    std::cout << "\nTriangular " << N << "x" << N << " multiply (speedup vs static threads):\n";
+    double base = time_ms([&] { static_threads_multiply(A, B, C); });
+    row("static std::threads (old)", base, base);
+    row("parallel_for static", time_ms([&] { parallel_multiply(A, B, C, StaticPartitioner{}); }), base);
+    row("parallel_for dynamic(4)", time_ms([&] { parallel_multiply(A, B, C, DynamicPartitioner{4}); }), base);
+    row("parallel_for guided", time_ms([&] { parallel_multiply(A, B, C, GuidedPartitioner{}); }), base);
+    row("parallel_for auto", time_ms([&] { parallel_multiply(A, B, C, AutoPartitioner{}); }), base);
+    std::cout << "  results match: " << std::boolalpha << (C == expected) << "\n";
+
+    // ── Imbalanced sum ────────────────────────────────────────────────
+    constexpr long long kRange = 20'000;
+    int threads = static_cast<int>(hw ? hw : 2);
+    long long want = static_threads_sum(kRange, threads);
+
+    std::cout << "\nImbalanced sum over " << kRange << " elements:\n";
+    long long got = 0;
+    base = time_ms([&] { got = static_threads_sum(kRange, threads); });
+    row("static std::threads (old)", base, base);
+    row("parallel_reduce static", time_ms([&] { got = compute_sum(kRange, StaticPartitioner{}); }), base);
+    row("parallel_reduce dynamic(256)", time_ms([&] { got = compute_sum(kRange, DynamicPartitioner{256}); }), base);
+    row("parallel_reduce guided", time_ms([&] { got = compute_sum(kRange, GuidedPartitioner{}); }), base);
+    row("parallel_reduce auto", time_ms([&] { got = compute_sum(kRange, AutoPartitioner{}); }), base);
+    std::cout << "  results match: " << (got == want) << "\n";
+
+    std::cout << "\nOn one core every split is serial, so all rows tie. With more cores\n"
+              << "the static split waits on its last (heaviest) chunk, while dynamic,\n"
+              << "guided and auto keep every participant busy until the range is empty.\n";
+    return 0;
+}
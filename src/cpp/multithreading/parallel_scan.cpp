@@ -0,0 +1,348 @@
+/**
+ * Parallel Prefix Sum (Scan)
+ *
+ * A scan turns a[0..n) into running totals:
+ *   inclusive: out[i] = a[0] + ... + a[i]
+ *   exclusive: out[i] = init + a[0] + ... + a[i-1]
+ * It is the building block behind stream compaction, radix sort and turning
+ * histogram counts into bucket offsets.
+ *
+ * Each output depends on every earlier input, so a scan looks serial. The
+ * two-pass (reduce-then-downsweep) algorithm splits the array into one chunk
+ * per thread:
+ *   1. reduce:    every thread sums its own chunk (like SumData in
+ *                 raw_pthread.cpp, which is exactly this pass)
+ *   2. offsets:   one thread scans the handful of chunk sums
+ *   3. downsweep: every thread scans its chunk again, starting from its
+ *                 chunk's offset
+ * Pass 1 and 3 each stream the data once, so the algorithm reads the input
+ * twice and writes the output once; it is memory-bandwidth bound.
+ *
+ * Within a chunk, int32 addition uses an in-register SIMD scan: a vector of
+ * 4 (SSE2) or 8 (AVX2) lanes is scanned with log2(lanes) shift+add steps,
+ * then the running carry from the previous vector is added to every lane.
+ * Any other type / operator uses the plain scalar loop.
+ *
+ * Compile: g++ -std=c++17 -O2 -march=native -pthread parallel_scan.cpp
+ * Run:     ./a.out [max_elements]   (default 100M; pass 1000000000 for 1B,
+ *                                    which needs ~8 GB of RAM)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// ─── Persistent pool (same design as thread_pool.cpp) ────────────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+ThreadPool& default_pool() {
+    static ThreadPool pool([] {
+        unsigned int hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 1;
+    }());
+    return pool;
+}
+
+// Run f(0..count-1) with f(0) on the caller and the rest on the pool.
+template <typename F>
+void run_chunks(ThreadPool& pool, size_t count, F&& f) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t remaining = count - 1;
+
+    for (size_t c = 1; c < count; ++c) {
+        pool.enqueue([&, c] {
+            f(c);
+            std::scoped_lock lock(mutex);
+            if (--remaining == 0) cv.notify_one();
+        });
+    }
+    f(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return remaining == 0; });
+}
+
+// ─── Per-chunk kernels ───────────────────────────────────────────────────────
+
+template <typename T, typename Op>
+T reduce_chunk(const T* in, size_t n, Op op) {
+    T acc = in[0];
+    for (size_t i = 1; i < n; ++i) acc = op(acc, in[i]);
+    return acc;
+}
+
+// Scan n elements. carry is the total of everything before this chunk, or
+// nullptr for the very first chunk of an inclusive scan.
+template <typename T, typename Op>
+void scan_chunk(const T* in, T* out, size_t n, const T* carry, Op op, bool exclusive) {
+    size_t i = 0;
+    T acc;
+    if (carry) {
+        acc = *carry;
+    } else {
+        acc = in[0];
+        out[0] = acc;
+        i = 1;
+    }
+    if (exclusive) {
+        for (; i < n; ++i) {
+            T x = in[i];
+            out[i] = acc;
+            acc = op(acc, x);
+        }
+    } else {
+        for (; i < n; ++i) {
+            acc = op(acc, in[i]);
+            out[i] = acc;
+        }
+    }
+}
+
+// int32 + int32: SIMD reduce and in-register scan.
+inline int32_t reduce_chunk(const int32_t* in, size_t n, std::plus<>) {
+    int32_t acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += in[i];  // auto-vectorised
+    return acc;
+}
+
+inline void scan_chunk(const int32_t* in, int32_t* out, size_t n, const int32_t* carry_in,
+                       std::plus<>, bool exclusive) {
+    int32_t carry = carry_in ? *carry_in : 0;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i vcarry = _mm256_set1_epi32(carry);
+    const __m256i last = _mm256_set1_epi32(7);
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        // Scan within each 128-bit half...
+        __m256i s = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        s = _mm256_add_epi32(s, _mm256_slli_si256(s, 8));
+        // ...then add the low half's total to every lane of the high half.
+        __m256i low_total = _mm256_shuffle_epi32(s, 0xFF);
+        s = _mm256_add_epi32(s, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+        s = _mm256_add_epi32(s, vcarry);
+        __m256i result = exclusive ? _mm256_sub_epi32(s, x) : s;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+        vcarry = _mm256_permutevar8x32_epi32(s, last);
+    }
+    carry = _mm256_cvtsi256_si32(vcarry);
+#elif defined(__SSE2__)
+    __m128i vcarry = _mm_set1_epi32(carry);
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i s = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        s = _mm_add_epi32(s, _mm_slli_si128(s, 8));
+        s = _mm_add_epi32(s, vcarry);
+        __m128i result = exclusive ? _mm_sub_epi32(s, x) : s;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+        vcarry = _mm_shuffle_epi32(s, 0xFF);
+    }
+    carry = _mm_cvtsi128_si32(vcarry);
+#endif
+
+    for (; i < n; ++i) {
+        int32_t x = in[i];
+        carry += x;
+        out[i] = exclusive ? carry - x : carry;
+    }
+}
+
+// ─── Two-pass parallel scan ──────────────────────────────────────────────────
+
+// Below this a single thread is faster than waking the pool.
+constexpr size_t kSerialCutoff = 1 << 16;
+
+template <typename T, typename Op>
+void parallel_scan(const T* in, T* out, size_t n, const T* init, Op op, bool exclusive,
+                   ThreadPool& pool) {
+    if (n == 0) return;
+
+    size_t chunks = std::min(pool.thread_count() + 1, (n + kSerialCutoff - 1) / kSerialCutoff);
+    if (chunks <= 1) {
+        scan_chunk(in, out, n, init, op, exclusive);
+        return;
+    }
+    size_t chunk_size = (n + chunks - 1) / chunks;
+    auto bounds = [&](size_t c) {
+        return std::pair<size_t, size_t>{c * chunk_size, std::min(n, (c + 1) * chunk_size)};
+    };
+
+    // Pass 1: chunk totals (the last chunk's total is never needed).
+    std::vector<T> sums(chunks);
+    run_chunks(pool, chunks - 1, [&](size_t c) {
+        auto [lo, hi] = bounds(c);
+        sums[c] = reduce_chunk(in + lo, hi - lo, op);
+    });
+
+    // Serial scan of the chunk totals gives each chunk its starting carry.
+    std::vector<T> offsets(chunks);
+    if (init) offsets[0] = *init;
+    for (size_t c = 1; c < chunks; ++c) {
+        offsets[c] = (c == 1 && !init) ? sums[0] : op(offsets[c - 1], sums[c - 1]);
+    }
+
+    // Pass 2: downsweep.
+    run_chunks(pool, chunks, [&](size_t c) {
+        auto [lo, hi] = bounds(c);
+        const T* carry = (c == 0 && !init) ? nullptr : &offsets[c];
+        scan_chunk(in + lo, out + lo, hi - lo, carry, op, exclusive);
+    });
+}
+
+template <typename T, typename Op = std::plus<>>
+void parallel_inclusive_scan(const T* first, const T* last, T* out, Op op = {},
+                             ThreadPool& pool = default_pool()) {
+    parallel_scan<T>(first, out, static_cast<size_t>(last - first), nullptr, op, false, pool);
+}
+
+template <typename T, typename Op = std::plus<>>
+void parallel_exclusive_scan(const T* first, const T* last, T* out, T init, Op op = {},
+                             ThreadPool& pool = default_pool()) {
+    parallel_scan<T>(first, out, static_cast<size_t>(last - first), &init, op, true, pool);
+}
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+template <typename F>
+double time_ms(F&& f, int runs = 3) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+void row(const char* name, double ms, size_t n, double baseline) {
+    double gbps = 2.0 * n * sizeof(int32_t) / (ms * 1e6);  // 1 read + 1 write stream
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << ms << " ms"
+              << std::setw(8) << std::setprecision(1) << gbps << " GB/s"
+              << std::setw(8) << std::setprecision(2) << baseline / ms << "x\n";
+}
+
+int main(int argc, char** argv) {
+    size_t max_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t{100'000'000};
+
+#if defined(__AVX2__)
+    const char* simd = "AVX2 (8 lanes)";
+#elif defined(__SSE2__)
+    const char* simd = "SSE2 (4 lanes)";
+#else
+    const char* simd = "none (scalar)";
+#endif
+    std::cout << "Threads: " << default_pool().thread_count() + 1 << ", SIMD: " << simd << "\n";
+
+    // A generic lambda dodges the int32/std::plus<> SIMD overloads.
+    auto scalar_plus = [](int32_t a, int32_t b) { return a + b; };
+
+    for (size_t n = 1'000'000; n <= max_n; n *= 10) {
+        std::vector<int32_t> in(n), expected(n), out(n);
+        for (size_t i = 0; i < n; ++i) in[i] = static_cast<int32_t>(i % 4);
+
+        std::cout << "\n" << n << " elements:\n";
+        double base = time_ms([&] { std::inclusive_scan(in.begin(), in.end(), expected.begin()); });
+        row("std::inclusive_scan", base, n, base);
+
+        double ms = time_ms([&] { parallel_inclusive_scan(in.data(), in.data() + n, out.data(), scalar_plus); });
+        bool ok = out == expected;
+        row("parallel inclusive (scalar)", ms, n, base);
+
+        std::fill(out.begin(), out.end(), 0);
+        ms = time_ms([&] { parallel_inclusive_scan(in.data(), in.data() + n, out.data()); });
+        ok = ok && out == expected;
+        row("parallel inclusive (SIMD)", ms, n, base);
+
+        ms = time_ms([&] { parallel_exclusive_scan(in.data(), in.data() + n, out.data(), int32_t{0}); });
+        ok = ok && out[0] == 0 && std::equal(out.begin() + 1, out.end(), expected.begin());
+        row("parallel exclusive (SIMD)", ms, n, base);
+
+        std::cout << "  results match: " << std::boolalpha << ok << "\n";
+    }
+
+    std::cout << "\nThe scan is bandwidth bound: SIMD mostly helps the single-threaded\n"
+              << "case, and extra threads help until the memory bus is saturated.\n";
+    return 0;
+}
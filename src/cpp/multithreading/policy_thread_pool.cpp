@@ -0,0 +1,535 @@
+/**
+ * Policy-Based Thread Pool Template
+ *
+ * Every pool variant in this directory (thread_pool.cpp, the work-stealing,
+ * spin-then-park and allocation-free pools, ...) differs from the others in
+ * only one or two decisions. Instead of copying the whole class each time,
+ * BasicThreadPool takes those decisions as template parameters:
+ *
+ *   BasicThreadPool<QueuePolicy, WaitPolicy, TaskStorage>
+ *
+ * QueuePolicy - where tasks wait
+ *   MutexFifo          one std::queue behind one mutex (thread_pool.cpp)
+ *   BoundedMpmcRing    lock-free bounded ring (Vyukov's MPMC queue);
+ *                      enqueue() backs off while the ring is full
+ *   WorkStealingQueues one deque per worker; owners pop LIFO from the back,
+ *                      idle workers steal FIFO from the front of others.
+ *                      Each deque has its own small lock so move-only tasks
+ *                      work; see work_stealing_thread_pool.cpp for the
+ *                      lock-free Chase-Lev version over pointers.
+ * WaitPolicy - what an idle worker does
+ *   CondvarWait        block on std::condition_variable
+ *   FutexWait          block on std::atomic::wait, wake only if someone sleeps
+ *   SpinWait           never block: spin with PAUSE, yielding now and then
+ * TaskStorage - how a task is stored
+ *   StdFunctionStorage std::function<void()>
+ *   SmallBufferStorage move-only task with 56 bytes of inline storage
+ *
+ * Policies are plain classes selected at compile time, so there are no
+ * virtual calls and unused policies cost nothing. ThreadPool, the default
+ * instantiation, behaves like thread_pool.cpp.
+ *
+ * The benchmark instantiates all 18 combinations and prints a throughput
+ * table.
+ *
+ * Compile: g++ -std=c++20 -O2 -pthread policy_thread_pool.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+inline void cpu_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#elif defined(__aarch64__)
+    __asm__ volatile("yield" ::: "memory");
+#endif
+}
+
+// ─── TaskStorage policies ────────────────────────────────────────────────────
+
+struct StdFunctionStorage {
+    static constexpr const char* name = "std::function";
+    using Task = std::function<void()>;
+};
+
+// Move-only callable with inline storage; falls back to the heap only for
+// callables larger than the buffer. See inplace_task_pool.cpp for details.
+class InplaceTask {
+public:
+    static constexpr std::size_t kInlineSize = 64 - sizeof(void*);
+
+    InplaceTask() noexcept = default;
+
+    template <typename F, typename D = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<D, InplaceTask>>>
+    InplaceTask(F&& f) {
+        if constexpr (sizeof(D) <= kInlineSize &&
+                      alignof(D) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<D>) {
+            ::new (static_cast<void*>(storage_)) D(std::forward<F>(f));
+            ops_ = &kInlineOps<D>;
+        } else {
+            ::new (static_cast<void*>(storage_)) D*(new D(std::forward<F>(f)));
+            ops_ = &kHeapOps<D>;
+        }
+    }
+
+    InplaceTask(InplaceTask&& other) noexcept { take(other); }
+    InplaceTask& operator=(InplaceTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    ~InplaceTask() { reset(); }
+
+    void operator()() { ops_->invoke(storage_); }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*relocate)(void* from, void* to) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename D>
+    static constexpr Ops kInlineOps{
+        [](void* p) { (*static_cast<D*>(p))(); },
+        [](void* from, void* to) noexcept {
+            ::new (to) D(std::move(*static_cast<D*>(from)));
+            static_cast<D*>(from)->~D();
+        },
+        [](void* p) noexcept { static_cast<D*>(p)->~D(); },
+    };
+
+    template <typename D>
+    static constexpr Ops kHeapOps{
+        [](void* p) { (**static_cast<D**>(p))(); },
+        [](void* from, void* to) noexcept { ::new (to) D*(*static_cast<D**>(from)); },
+        [](void* p) noexcept { delete *static_cast<D**>(p); },
+    };
+
+    void take(InplaceTask& other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(other.storage_, storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+
+    void reset() noexcept {
+        if (ops_) ops_->destroy(storage_);
+        ops_ = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+struct SmallBufferStorage {
+    static constexpr const char* name = "small-buffer";
+    using Task = InplaceTask;
+};
+
+// ─── QueuePolicy ─────────────────────────────────────────────────────────────
+//
+// template <typename Task> class Q {
+//     Q(size_t workers, size_t capacity);
+//     bool try_push(Task&& task);             // false = full, try again
+//     bool try_pop(Task& out, size_t worker); // false = nothing found
+// };
+
+struct MutexFifo {
+    static constexpr const char* name = "mutex FIFO";
+
+    template <typename Task>
+    class Queue {
+    public:
+        Queue(size_t, size_t) {}
+
+        bool try_push(Task&& task) {
+            std::scoped_lock lock(mutex_);
+            tasks_.push(std::move(task));
+            return true;
+        }
+
+        bool try_pop(Task& out, size_t) {
+            std::scoped_lock lock(mutex_);
+            if (tasks_.empty()) return false;
+            out = std::move(tasks_.front());
+            tasks_.pop();
+            return true;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::queue<Task> tasks_;
+    };
+};
+
+struct BoundedMpmcRing {
+    static constexpr const char* name = "MPMC ring";
+
+    // Dmitry Vyukov's bounded MPMC queue: each cell carries a sequence number
+    // that tells producers and consumers whether it is free or full, so the
+    // only shared writes are one CAS on enqueue_pos_ or dequeue_pos_.
+    template <typename Task>
+    class Queue {
+    public:
+        Queue(size_t, size_t capacity) : mask_(round_up(capacity) - 1), cells_(mask_ + 1) {
+            for (size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool try_push(Task&& task) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells_[pos & mask_];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.task = std::move(task);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;  // full
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(Task& out, size_t) {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells_[pos & mask_];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        out = std::move(cell.task);
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;  // empty
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            Task task;
+        };
+
+        static size_t round_up(size_t n) {
+            size_t p = 2;
+            while (p < n) p <<= 1;
+            return p;
+        }
+
+        size_t mask_;
+        std::vector<Cell> cells_;
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    };
+};
+
+struct WorkStealingQueues {
+    static constexpr const char* name = "work-stealing";
+
+    template <typename Task>
+    class Queue {
+    public:
+        Queue(size_t workers, size_t) : lanes_(workers == 0 ? 1 : workers) {}
+
+        // Called from a worker of this queue: push to its own deque.
+        // Called from outside: spread round-robin.
+        bool try_push(Task&& task) {
+            size_t lane = (tls_owner_ == this) ? tls_worker_
+                        : next_.fetch_add(1, std::memory_order_relaxed) % lanes_.size();
+            std::scoped_lock lock(lanes_[lane].mutex);
+            lanes_[lane].tasks.push_back(std::move(task));
+            return true;
+        }
+
+        bool try_pop(Task& out, size_t worker) {
+            if (tls_owner_ != this) {
+                tls_owner_ = this;
+                tls_worker_ = worker;
+            }
+            {
+                Lane& own = lanes_[worker];
+                std::scoped_lock lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    out = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return true;
+                }
+            }
+            for (size_t k = 1; k < lanes_.size(); ++k) {
+                Lane& victim = lanes_[(worker + k) % lanes_.size()];
+                std::unique_lock lock(victim.mutex, std::try_to_lock);
+                if (lock && !victim.tasks.empty()) {
+                    out = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct alignas(64) Lane {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        static inline thread_local const void* tls_owner_ = nullptr;
+        static inline thread_local size_t tls_worker_ = 0;
+
+        std::vector<Lane> lanes_;
+        std::atomic<size_t> next_{0};
+    };
+};
+
+// ─── WaitPolicy ──────────────────────────────────────────────────────────────
+//
+// class W {
+//     template <typename Pred> void wait(Pred ready);  // return once ready()
+//     void notify_one();
+//     void notify_all();
+// };
+
+struct CondvarWait {
+    static constexpr const char* name = "condvar";
+
+    template <typename Pred>
+    void wait(Pred ready) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, ready);
+    }
+
+    // Taking the mutex orders the notify after any in-progress predicate
+    // check, which is what prevents lost wake-ups.
+    void notify_one() {
+        { std::scoped_lock lock(mutex_); }
+        cv_.notify_one();
+    }
+
+    void notify_all() {
+        { std::scoped_lock lock(mutex_); }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+struct FutexWait {
+    static constexpr const char* name = "futex";
+
+    template <typename Pred>
+    void wait(Pred ready) {
+        sleepers_.fetch_add(1);
+        while (true) {
+            unsigned epoch = epoch_.load();
+            if (ready()) break;
+            epoch_.wait(epoch);
+        }
+        sleepers_.fetch_sub(1);
+    }
+
+    void notify_one() {
+        if (sleepers_.load() == 0) return;  // nobody parked: skip the syscall
+        epoch_.fetch_add(1);
+        epoch_.notify_one();
+    }
+
+    void notify_all() {
+        epoch_.fetch_add(1);
+        epoch_.notify_all();
+    }
+
+private:
+    alignas(64) std::atomic<unsigned> epoch_{0};
+    alignas(64) std::atomic<int> sleepers_{0};
+};
+
+struct SpinWait {
+    static constexpr const char* name = "spin";
+
+    template <typename Pred>
+    void wait(Pred ready) {
+        for (unsigned i = 1; !ready(); ++i) {
+            cpu_pause();
+            // Yield occasionally so an oversubscribed machine still progresses.
+            if ((i & 63) == 0) std::this_thread::yield();
+        }
+    }
+
+    void notify_one() {}
+    void notify_all() {}
+};
+
+// ─── BasicThreadPool ─────────────────────────────────────────────────────────
+
+template <typename QueuePolicy = MutexFifo,
+          typename WaitPolicy = CondvarWait,
+          typename TaskStorage = StdFunctionStorage>
+class BasicThreadPool {
+public:
+    using Task = typename TaskStorage::Task;
+
+    explicit BasicThreadPool(size_t num_threads, size_t queue_capacity = 4096)
+        : queue_(num_threads, queue_capacity) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&BasicThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~BasicThreadPool() {
+        stop_.store(true);
+        wait_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    BasicThreadPool(const BasicThreadPool&) = delete;
+    BasicThreadPool& operator=(const BasicThreadPool&) = delete;
+
+    template <typename F>
+    void enqueue(F&& f) {
+        if (stop_.load(std::memory_order_relaxed))
+            throw std::runtime_error("enqueue() called on a stopped BasicThreadPool");
+        Task task(std::forward<F>(f));
+        while (!queue_.try_push(std::move(task))) {
+            std::this_thread::yield();  // bounded queue full: back off
+        }
+        pending_.fetch_add(1);
+        wait_.notify_one();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+        std::future<ReturnType> fut = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return fut;
+    }
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    void worker_loop(size_t index) {
+        Task task;
+        while (true) {
+            if (queue_.try_pop(task, index)) {
+                pending_.fetch_sub(1);
+                task();
+                task = Task();
+                continue;
+            }
+            if (stop_.load() && pending_.load() == 0) return;
+            wait_.wait([this] { return pending_.load() > 0 || stop_.load(); });
+        }
+    }
+
+    typename QueuePolicy::template Queue<Task> queue_;
+    WaitPolicy wait_;
+    alignas(64) std::atomic<long> pending_{0};
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> workers_;
+};
+
+// Today's behaviour: one mutex-protected FIFO, condvar wake-ups, std::function.
+using ThreadPool = BasicThreadPool<>;
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+constexpr size_t kThreads = 4;
+constexpr int kTasks = 100'000;
+
+template <typename Q, typename W, typename S>
+void bench_one() {
+    std::atomic<int> done{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        BasicThreadPool<Q, W, S> pool(kThreads);
+        for (int i = 0; i < kTasks; ++i) {
+            pool.enqueue([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_relaxed) < kTasks) std::this_thread::yield();
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "  " << std::left << std::setw(16) << Q::name << std::setw(10) << W::name
+              << std::setw(16) << S::name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << kTasks / ms / 1000.0 << "\n";
+}
+
+template <typename Q, typename W>
+void bench_storages() {
+    bench_one<Q, W, StdFunctionStorage>();
+    bench_one<Q, W, SmallBufferStorage>();
+}
+
+template <typename Q>
+void bench_waits() {
+    bench_storages<Q, CondvarWait>();
+    bench_storages<Q, FutexWait>();
+    bench_storages<Q, SpinWait>();
+}
+
+int main() {
+    ThreadPool pool(2);
+    auto answer = pool.submit([](int a, int b) { return a + b; }, 40, 2);
+    std::cout << "Default ThreadPool: 40 + 2 = " << answer.get() << "\n\n";
+
+    std::cout << "=== " << kTasks << " tiny tasks, " << kThreads << " workers ===\n\n";
+    std::cout << "  " << std::left << std::setw(16) << "queue" << std::setw(10) << "wait"
+              << std::setw(16) << "storage" << std::right << std::setw(10) << "M tasks/s" << "\n";
+
+    bench_waits<MutexFifo>();
+    bench_waits<BoundedMpmcRing>();
+    bench_waits<WorkStealingQueues>();
+
+    std::cout << "\nNote: spin waiting trades CPU time for throughput. It burns a\n"
+              << "core per idle worker, so compare it against the blocking policies\n"
+              << "under your real load, not only in an otherwise idle benchmark.\n";
+    return 0;
+}
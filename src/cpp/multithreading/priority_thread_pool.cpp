@@ -0,0 +1,300 @@
+/**
+ * Thread Pool with Priority Lanes
+ *
+ * ThreadPool (thread_pool.cpp) keeps every task in one FIFO. When a flood
+ * of background batch work is queued, a latency-critical request submitted
+ * afterwards has to wait for the whole backlog to drain first.
+ *
+ * This pool keeps three lanes: High, Normal and Background. Workers drain
+ * them with weighted round-robin (by default 8:4:1), so:
+ * - high-priority tasks overtake queued background work
+ * - lower lanes are still guaranteed a share of the workers and can never
+ *   starve, no matter how much high-priority work arrives
+ *
+ * A strict priority queue would give slightly better high-priority latency
+ * but would let a busy High lane starve Background forever; weights are the
+ * standard compromise (compare Linux CFS nice levels or DRR in networking).
+ *
+ * The benchmark saturates the Background lane and measures tail latency of
+ * periodic High-priority tasks in the old single-FIFO pool and the laned pool.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread priority_thread_pool.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+enum class Priority { High = 0, Normal = 1, Background = 2 };
+
+// ─── Baseline: single FIFO (same design as thread_pool.cpp) ──────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Priority is accepted for interface parity and ignored.
+    void enqueue(std::function<void()> task, Priority = Priority::Normal) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// ─── Laned pool ──────────────────────────────────────────────────────────────
+
+class PriorityThreadPool {
+public:
+    static constexpr size_t kLanes = 3;
+    using Weights = std::array<int, kLanes>;
+
+    explicit PriorityThreadPool(size_t num_threads, Weights weights = {8, 4, 1})
+        : weights_(weights), credits_(weights) {
+        for (int w : weights_) {
+            if (w <= 0) throw std::invalid_argument("lane weights must be positive");
+        }
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&PriorityThreadPool::worker_loop, this);
+        }
+    }
+
+    ~PriorityThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    PriorityThreadPool(const PriorityThreadPool&) = delete;
+    PriorityThreadPool& operator=(const PriorityThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task, Priority priority = Priority::Normal) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            if (stop_)
+                throw std::runtime_error("enqueue() called on a stopped PriorityThreadPool");
+            lanes_[static_cast<size_t>(priority)].push(std::move(task));
+            ++queued_;
+        }
+        cv_.notify_one();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(Priority priority, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+        std::future<ReturnType> fut = task->get_future();
+        enqueue([task]() { (*task)(); }, priority);
+        return fut;
+    }
+
+private:
+    // Weighted round-robin: each lane may run up to weights_[lane] tasks per
+    // round. A lane with no credit left, or no tasks, is skipped; when no
+    // non-empty lane has credit, a new round starts. Called with the lock held.
+    std::function<void()> pop_next_locked() {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                if (!lanes_[lane].empty() && credits_[lane] > 0) {
+                    --credits_[lane];
+                    auto task = std::move(lanes_[lane].front());
+                    lanes_[lane].pop();
+                    --queued_;
+                    return task;
+                }
+            }
+            credits_ = weights_;
+        }
+        return nullptr;  // unreachable while queued_ > 0
+    }
+
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || queued_ > 0;
+                });
+
+                if (stop_ && queued_ == 0) {
+                    return;
+                }
+
+                task = pop_next_locked();
+            }
+
+            task();
+        }
+    }
+
+    Weights weights_;
+    Weights credits_;
+    std::array<std::queue<std::function<void()>>, kLanes> lanes_;
+    size_t queued_ = 0;
+    std::vector<std::thread> workers_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kThreads = 4;
+constexpr int kBackgroundTasks = 20000;
+constexpr int kHighTasks = 200;
+constexpr auto kBackgroundWork = std::chrono::microseconds(20);
+constexpr auto kHighInterval = std::chrono::microseconds(500);
+
+void spin_for(std::chrono::nanoseconds d) {
+    auto end = Clock::now() + d;
+    while (Clock::now() < end) {
+    }
+}
+
+struct Latency {
+    double p50_us, p99_us, max_us;
+    double background_ms;
+};
+
+// Queue a large background backlog, then trickle in High tasks and record
+// how long each waited before starting.
+template <typename Pool>
+Latency measure() {
+    std::vector<double> waits(kHighTasks);
+    std::atomic<int> high_done{0};
+    std::atomic<int> background_done{0};
+    auto start = Clock::now();
+
+    Pool pool(kThreads);
+    for (int i = 0; i < kBackgroundTasks; ++i) {
+        pool.enqueue([&background_done] {
+            spin_for(kBackgroundWork);
+            background_done.fetch_add(1, std::memory_order_relaxed);
+        }, Priority::Background);
+    }
+
+    for (int i = 0; i < kHighTasks; ++i) {
+        auto enqueued = Clock::now();
+        pool.enqueue([&waits, &high_done, enqueued, i] {
+            waits[i] = std::chrono::duration<double, std::micro>(Clock::now() - enqueued).count();
+            high_done.fetch_add(1, std::memory_order_release);
+        }, Priority::High);
+        std::this_thread::sleep_for(kHighInterval);
+    }
+
+    while (high_done.load(std::memory_order_acquire) < kHighTasks ||
+           background_done.load(std::memory_order_relaxed) < kBackgroundTasks) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double background_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::sort(waits.begin(), waits.end());
+    auto pct = [&](double p) { return waits[static_cast<size_t>(p * (waits.size() - 1))]; };
+    return {pct(0.50), pct(0.99), waits.back(), background_ms};
+}
+
+void print_row(const char* name, const Latency& l) {
+    std::cout << "  " << std::left << std::setw(20) << name << std::right
+              << std::fixed << std::setprecision(0)
+              << std::setw(12) << l.p50_us << std::setw(12) << l.p99_us
+              << std::setw(12) << l.max_us << std::setw(14) << l.background_ms << "\n";
+}
+
+int main() {
+    std::cout << "=== " << kBackgroundTasks << " background tasks ("
+              << kBackgroundWork.count() << " us each) + " << kHighTasks
+              << " high-priority tasks, " << kThreads << " workers ===\n\n";
+    std::cout << "  " << std::left << std::setw(20) << "pool" << std::right
+              << std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)"
+              << std::setw(12) << "max (us)" << std::setw(14) << "total (ms)" << "\n";
+
+    print_row("single FIFO (old)", measure<ThreadPool>());
+    print_row("priority lanes", measure<PriorityThreadPool>());
+
+    // submit() with a priority returns a regular future.
+    PriorityThreadPool pool(2);
+    auto answer = pool.submit(Priority::High, [](int a, int b) { return a * b; }, 6, 7);
+    std::cout << "\nsubmit(High, 6 * 7) = " << answer.get() << "\n";
+    std::cout << "\nNote: total time is about the same for both pools; lanes\n"
+              << "only reorder work, they do not make the backlog smaller.\n";
+    return 0;
+}
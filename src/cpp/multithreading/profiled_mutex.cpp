@@ -0,0 +1,496 @@
+/**
+ * Contention Profiler: ProfiledMutex<M>
+ *
+ * mutex_contention.cpp, starvation.cpp and recursive_mutex.cpp each use one
+ * lock, and it's obvious which one is hot. In a real program there are
+ * dozens, and "which lock are we waiting on?" needs data.
+ *
+ * ProfiledMutex<M> wraps any mutex (std::mutex, std::recursive_mutex,
+ * std::shared_mutex, Spinlock, ...) and keeps the same interface, so it
+ * drops into std::scoped_lock / std::unique_lock / std::shared_lock. Each
+ * acquisition is charged to a lock site: the mutex's own name by default,
+ * or a specific call site via ProfiledLock guard(m, site). Per site:
+ *
+ *   acquisitions   how often it was taken
+ *   contended      how often try_lock() failed and the thread had to wait
+ *   wait           total and max time spent waiting (contended only)
+ *   hold           time between acquire and release (exclusive locks only)
+ *
+ * Keeping it cheap enough to leave on:
+ * - counters are per-thread (thread_local), written only by their owner
+ *   with relaxed load + store: no shared cache line, no atomic RMW
+ * - the uncontended path is try_lock() + a counter bump; the clock is only
+ *   read when the thread actually has to wait
+ * - hold time is sampled: on average one in kHoldSampleEvery exclusive
+ *   acquisitions per thread is timed, and the total is scaled up by the
+ *   number of holds: outermost exclusive acquisitions only, since nested
+ *   recursive acquisitions and shared ones never start a hold
+ *
+ * LockProfiler::instance().print_report() sums all threads' counters (live
+ * and exited) and lists sites by total wait time.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread profiled_mutex.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─── Per-thread counters ─────────────────────────────────────────────────────
+
+constexpr std::size_t kMaxSites = 256;
+constexpr uint32_t kHoldSampleEvery = 16;
+
+using Clock = std::chrono::steady_clock;
+
+inline uint64_t elapsed_ns(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+}
+
+struct SiteCounters {
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+    std::atomic<uint64_t> holds{0};  // outermost exclusive acquisitions
+    std::atomic<uint64_t> hold_samples{0};
+    std::atomic<uint64_t> hold_ns{0};
+};
+
+// Only the owning thread writes; the report reads with relaxed loads.
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+struct ThreadCounters {
+    ThreadCounters();
+    ~ThreadCounters();
+
+    std::array<SiteCounters, kMaxSites> sites;
+    uint32_t hold_countdown = 0;
+    uint32_t rng = 0x9e3779b9u;
+
+    // Gap to the next hold sample: random in [0, 2 * kHoldSampleEvery), so
+    // periodic lock patterns can't alias with the sampling period.
+    uint32_t next_gap() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng % (2 * kHoldSampleEvery);
+    }
+};
+
+inline ThreadCounters& local_counters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+// ─── Registry and report ─────────────────────────────────────────────────────
+
+struct SiteReport {
+    std::string name;
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t wait_ns = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t holds = 0;
+    uint64_t hold_samples = 0;
+    uint64_t hold_ns = 0;  // sampled
+
+    double avg_hold_ns() const { return hold_samples ? double(hold_ns) / hold_samples : 0.0; }
+    double est_total_hold_ns() const { return avg_hold_ns() * holds; }
+};
+
+class LockProfiler {
+public:
+    static LockProfiler& instance() {
+        static LockProfiler profiler;
+        return profiler;
+    }
+
+    // Site ids are stable for the life of the process. Past kMaxSites, new
+    // sites share the last slot.
+    std::size_t register_site(std::string name) {
+        std::scoped_lock lock(mutex_);
+        if (names_.size() == kMaxSites - 1) names_.push_back("(other sites)");
+        if (names_.size() == kMaxSites) return kMaxSites - 1;
+        names_.push_back(std::move(name));
+        return names_.size() - 1;
+    }
+
+    void attach(ThreadCounters* counters) {
+        std::scoped_lock lock(mutex_);
+        live_.push_back(counters);
+    }
+
+    // An exiting thread folds its counters into the retired totals.
+    void detach(ThreadCounters* counters) {
+        std::scoped_lock lock(mutex_);
+        accumulate(*counters, retired_);
+        live_.erase(std::find(live_.begin(), live_.end(), counters));
+    }
+
+    // Sites with at least one acquisition, by total wait time (descending).
+    std::vector<SiteReport> report() {
+        std::scoped_lock lock(mutex_);
+        std::vector<SiteReport> totals = retired_;
+        for (ThreadCounters* counters : live_) accumulate(*counters, totals);
+
+        std::vector<SiteReport> sites;
+        for (std::size_t i = 0; i < names_.size(); ++i) {
+            if (totals[i].acquisitions == 0) continue;
+            totals[i].name = names_[i];
+            sites.push_back(totals[i]);
+        }
+        std::sort(sites.begin(), sites.end(),
+                  [](const SiteReport& a, const SiteReport& b) { return a.wait_ns > b.wait_ns; });
+        return sites;
+    }
+
+    void print_report(std::ostream& out = std::cout) {
+        out << std::left << std::setw(28) << "site" << std::right << std::setw(10) << "acquired"
+            << std::setw(11) << "contended" << std::setw(14) << "wait total" << std::setw(12)
+            << "wait max" << std::setw(12) << "hold avg" << std::setw(14) << "hold total\n";
+        for (const SiteReport& s : report()) {
+            out << std::left << std::setw(28) << s.name << std::right << std::setw(10) << s.acquisitions
+                << std::setw(10) << std::fixed << std::setprecision(1)
+                << 100.0 * s.contended / s.acquisitions << "%" << std::setprecision(2)
+                << std::setw(11) << s.wait_ns / 1e6 << " ms" << std::setw(9) << s.max_wait_ns / 1e3
+                << " us";
+            if (s.hold_samples) {
+                out << std::setw(9) << std::setprecision(0) << s.avg_hold_ns() << " ns"
+                    << std::setw(10) << std::setprecision(2) << s.est_total_hold_ns() / 1e6 << " ms";
+            } else {
+                out << std::setw(12) << "-" << std::setw(13) << "-";
+            }
+            out << "\n";
+        }
+    }
+
+private:
+    LockProfiler() : retired_(kMaxSites) {}
+
+    static void accumulate(const ThreadCounters& counters, std::vector<SiteReport>& into) {
+        for (std::size_t i = 0; i < kMaxSites; ++i) {
+            const SiteCounters& c = counters.sites[i];
+            SiteReport& r = into[i];
+            r.acquisitions += c.acquisitions.load(std::memory_order_relaxed);
+            r.contended += c.contended.load(std::memory_order_relaxed);
+            r.wait_ns += c.wait_ns.load(std::memory_order_relaxed);
+            r.max_wait_ns = std::max(r.max_wait_ns, c.max_wait_ns.load(std::memory_order_relaxed));
+            r.holds += c.holds.load(std::memory_order_relaxed);
+            r.hold_samples += c.hold_samples.load(std::memory_order_relaxed);
+            r.hold_ns += c.hold_ns.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::mutex mutex_;
+    std::vector<std::string> names_;
+    std::vector<ThreadCounters*> live_;
+    std::vector<SiteReport> retired_;
+};
+
+// The profiler singleton is constructed before the first ThreadCounters,
+// so it outlives them all (including main's thread_locals).
+ThreadCounters::ThreadCounters() { LockProfiler::instance().attach(this); }
+ThreadCounters::~ThreadCounters() { LockProfiler::instance().detach(this); }
+
+class LockSite {
+public:
+    explicit LockSite(std::string name) : id_(LockProfiler::instance().register_site(std::move(name))) {}
+    std::size_t id() const { return id_; }
+
+private:
+    std::size_t id_;
+};
+
+// ─── ProfiledMutex ───────────────────────────────────────────────────────────
+
+template <typename M>
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(std::string name) : site_(std::move(name)) {}
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    // Exclusive
+
+    void lock() { lock_at(site_); }
+
+    void lock_at(const LockSite& site) {
+        SiteCounters& c = local_counters().sites[site.id()];
+        if (!mutex_.try_lock()) {
+            auto start = Clock::now();
+            mutex_.lock();
+            record_wait(c, elapsed_ns(start));
+        }
+        bump(c.acquisitions);
+        start_hold(c);
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) return false;
+        SiteCounters& c = local_counters().sites[site_.id()];
+        bump(c.acquisitions);
+        start_hold(c);
+        return true;
+    }
+
+    void unlock() {
+        // Only the outermost release of a recursive lock ends the hold.
+        if (--depth_ == 0 && hold_site_) {
+            SiteCounters* c = hold_site_;
+            hold_site_ = nullptr;
+            uint64_t held = elapsed_ns(held_since_);
+            mutex_.unlock();
+            bump(c->hold_samples);
+            bump(c->hold_ns, held);
+            return;
+        }
+        mutex_.unlock();
+    }
+
+    // Shared (std::shared_mutex only). Readers overlap, so hold time is not
+    // tracked for them.
+
+    void lock_shared() { lock_shared_at(site_); }
+
+    void lock_shared_at(const LockSite& site) {
+        SiteCounters& c = local_counters().sites[site.id()];
+        if (!mutex_.try_lock_shared()) {
+            auto start = Clock::now();
+            mutex_.lock_shared();
+            record_wait(c, elapsed_ns(start));
+        }
+        bump(c.acquisitions);
+    }
+
+    bool try_lock_shared() {
+        if (!mutex_.try_lock_shared()) return false;
+        bump(local_counters().sites[site_.id()].acquisitions);
+        return true;
+    }
+
+    void unlock_shared() { mutex_.unlock_shared(); }
+
+    const LockSite& site() const { return site_; }
+
+private:
+    static void record_wait(SiteCounters& c, uint64_t waited) {
+        bump(c.contended);
+        bump(c.wait_ns, waited);
+        if (waited > c.max_wait_ns.load(std::memory_order_relaxed)) {
+            c.max_wait_ns.store(waited, std::memory_order_relaxed);
+        }
+    }
+
+    // Called with the lock held: depth_, hold_site_ and held_since_ belong
+    // to the holder.
+    void start_hold(SiteCounters& c) {
+        if (depth_++ != 0) return;
+        bump(c.holds);
+        ThreadCounters& local = local_counters();
+        if (local.hold_countdown-- == 0) {
+            local.hold_countdown = local.next_gap();
+            hold_site_ = &c;
+            held_since_ = Clock::now();
+        }
+    }
+
+    M mutex_;
+    LockSite site_;
+    unsigned depth_ = 0;
+    SiteCounters* hold_site_ = nullptr;
+    Clock::time_point held_since_;
+};
+
+// Charges an exclusive acquisition to a specific call site.
+template <typename M>
+class ProfiledLock {
+public:
+    ProfiledLock(ProfiledMutex<M>& mutex, const LockSite& site) : mutex_(mutex) { mutex_.lock_at(site); }
+    ~ProfiledLock() { mutex_.unlock(); }
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+private:
+    ProfiledMutex<M>& mutex_;
+};
+
+// ─── Spinlock (spinlock.cpp, plus try_lock) ──────────────────────────────────
+
+class Spinlock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+#if defined(__x86_64__) || defined(__i386__)
+            __asm__ volatile("pause" ::: "memory");
+#endif
+        }
+    }
+
+    bool try_lock() noexcept {
+        return !flag_.test_and_set(std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+// ─── Demo: mutex_contention.cpp ──────────────────────────────────────────────
+
+void demo_mutex_contention() {
+    ProfiledMutex<std::mutex> task_lock("contention: task_lock");
+    int task_count = 5000;
+
+    auto worker = [&](int id) {
+        while (true) {
+            std::scoped_lock lock(task_lock);
+            if (task_count <= 0) break;
+            --task_count;
+            if (id == 0 && task_count == 100) break;  // early exit, as in the original
+        }
+    };
+    std::thread alice(worker, 0);
+    std::thread bob(worker, 1);
+    alice.join();
+    bob.join();
+}
+
+// ─── Demo: starvation.cpp ────────────────────────────────────────────────────
+
+void demo_starvation() {
+    ProfiledMutex<std::mutex> task_lock("starvation: task_lock");
+    int task_count = 5000;
+
+    std::array<std::thread, 200> workers;
+    for (auto& w : workers) {
+        w = std::thread([&] {
+            while (true) {
+                std::scoped_lock lock(task_lock);
+                if (task_count <= 0) break;
+                --task_count;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+}
+
+// ─── Demo: recursive_mutex.cpp, one site per function ────────────────────────
+
+ProfiledMutex<std::recursive_mutex> counter_mutex("recursive: counter_mutex");
+const LockSite add_document_site("recursive: add_document");
+const LockSite add_report_site("recursive: add_report");
+unsigned int document_count = 0;
+unsigned int report_count = 0;
+
+void add_document() {
+    ProfiledLock lock(counter_mutex, add_document_site);
+    ++document_count;
+}
+
+void add_report() {
+    ProfiledLock lock(counter_mutex, add_report_site);
+    ++report_count;
+    add_document();  // re-enters counter_mutex
+}
+
+void demo_recursive_mutex() {
+    auto worker = [] {
+        for (int i = 0; i < 10000; ++i) {
+            add_document();
+            add_report();
+        }
+    };
+    std::thread alice(worker);
+    std::thread bob(worker);
+    alice.join();
+    bob.join();
+}
+
+// ─── Demo: shared_mutex readers and Spinlock ─────────────────────────────────
+
+void demo_shared_and_spin() {
+    ProfiledMutex<std::shared_mutex> table_mutex("shared: table");
+    ProfiledMutex<Spinlock> stats_lock("spinlock: stats");
+    LockSite writer_site("shared: table (writer)");
+    int table = 0;
+    long reads = 0;
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < 3; ++r) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20000; ++i) {
+                int value;
+                {
+                    std::shared_lock lock(table_mutex);
+                    value = table;
+                }
+                std::scoped_lock lock(stats_lock);
+                reads += value >= 0;
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        for (int i = 0; i < 2000; ++i) {
+            ProfiledLock lock(table_mutex, writer_site);
+            ++table;
+        }
+    });
+    for (auto& t : threads) t.join();
+}
+
+// ─── Overhead ────────────────────────────────────────────────────────────────
+
+template <typename Lock>
+double uncontended_ns(Lock& lock, int iterations) {
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        lock.lock();
+        lock.unlock();
+    }
+    return double(elapsed_ns(start)) / iterations;
+}
+
+void measure_overhead() {
+    constexpr int kIterations = 5'000'000;
+    std::mutex plain;
+    ProfiledMutex<std::mutex> profiled("overhead: uncontended");
+    uncontended_ns(plain, kIterations / 10);  // warm up
+    double plain_ns = uncontended_ns(plain, kIterations);
+    double profiled_ns = uncontended_ns(profiled, kIterations);
+    std::cout << std::fixed << std::setprecision(1) << "Uncontended lock+unlock: std::mutex "
+              << plain_ns << " ns, ProfiledMutex<std::mutex> " << profiled_ns << " ns (+"
+              << profiled_ns - plain_ns << " ns)\n\n";
+}
+
+int main() {
+    demo_mutex_contention();
+    demo_starvation();
+    demo_recursive_mutex();
+    demo_shared_and_spin();
+    measure_overhead();
+
+    std::cout << "Documents: " << document_count << ", reports: " << report_count
+              << " (expected 40000, 20000)\n\n";
+    LockProfiler::instance().print_report();
+    std::cout << "\nHold times are sampled (about 1 in " << kHoldSampleEvery
+              << " exclusive acquisitions); totals are scaled estimates.\n"
+              << "Nested acquisitions of a recursive mutex are charged to the outermost site.\n";
+    return 0;
+}
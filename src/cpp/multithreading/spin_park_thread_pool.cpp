@@ -0,0 +1,318 @@
+/**
+ * Spin-Then-Park Idle Strategy for Thread Pool Workers
+ *
+ * ThreadPool::worker_loop (thread_pool.cpp) calls cv_.wait the instant the
+ * queue is empty. For bursty workloads each new task then pays a futex wake
+ * plus a context switch before it starts: tens of microseconds of dispatch
+ * latency even on an otherwise idle machine.
+ *
+ * A hybrid idle strategy trades a little CPU for much lower latency:
+ * 1. Spin: re-check the queue in a tight loop with the PAUSE hint
+ * 2. Yield: give the core away with std::this_thread::yield(), but stay
+ *    runnable so the next check happens soon
+ * 3. Park: block on std::atomic::wait (a futex on Linux)
+ *
+ * The pool keeps a count of parked workers. enqueue() only issues a wake-up
+ * when that count is non-zero, so while a worker is still spinning the
+ * producer pays no syscall at all.
+ *
+ * Lost wake-ups are avoided with sequentially consistent ordering: a worker
+ * increments sleepers_ before its final emptiness check, and enqueue()
+ * increments queued_ before reading sleepers_. At least one of the two
+ * threads is guaranteed to see the other's write.
+ *
+ * The benchmark submits tasks with short random gaps and reports p50/p99
+ * dispatch latency (enqueue -> task start) per strategy.
+ *
+ * Compile: g++ -std=c++20 -O2 -pthread spin_park_thread_pool.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+inline void cpu_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#elif defined(__aarch64__)
+    __asm__ volatile("yield" ::: "memory");
+#endif
+}
+
+struct IdleStrategy {
+    const char* name;
+    std::chrono::microseconds spin;  // phase 1 budget
+    int yields;                      // phase 2 budget
+    bool park;                       // phase 3; false = never block
+
+    static IdleStrategy park_immediately() { return {"park", std::chrono::microseconds(0), 0, true}; }
+    static IdleStrategy spin_then_park()   { return {"spin+yield+park", std::chrono::microseconds(50), 100, true}; }
+    static IdleStrategy spin_only()        { return {"spin only", std::chrono::microseconds(0), 0, false}; }
+};
+
+// ─── Baseline: the condition_variable pool from thread_pool.cpp ──────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// ─── Pool with a configurable idle strategy ──────────────────────────────────
+
+class SpinParkThreadPool {
+public:
+    SpinParkThreadPool(size_t num_threads, IdleStrategy strategy)
+        : strategy_(strategy) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&SpinParkThreadPool::worker_loop, this);
+        }
+    }
+
+    ~SpinParkThreadPool() {
+        stop_.store(true);
+        wake_epoch_.fetch_add(1);
+        wake_epoch_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    SpinParkThreadPool(const SpinParkThreadPool&) = delete;
+    SpinParkThreadPool& operator=(const SpinParkThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        queued_.fetch_add(1);
+
+        // A spinning worker will see queued_ on its own: skip the syscall.
+        if (sleepers_.load() > 0) {
+            wake_epoch_.fetch_add(1);
+            wake_epoch_.notify_one();
+            wakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    long wakeups() const { return wakeups_.load(); }
+
+private:
+    bool try_pop(std::function<void()>& task) {
+        if (queued_.load(std::memory_order_relaxed) == 0) return false;
+        std::scoped_lock lock(queue_mutex_);
+        if (tasks_.empty()) return false;
+        task = std::move(tasks_.front());
+        tasks_.pop();
+        queued_.fetch_sub(1);
+        return true;
+    }
+
+    bool has_work() const {
+        return queued_.load(std::memory_order_relaxed) > 0 ||
+               stop_.load(std::memory_order_relaxed);
+    }
+
+    void idle() {
+        // Phase 1: spin. The clock is read every 64 iterations only.
+        if (strategy_.spin.count() > 0) {
+            auto deadline = Clock::now() + strategy_.spin;
+            for (unsigned i = 1;; ++i) {
+                if (has_work()) return;
+                cpu_pause();
+                if ((i & 63) == 0 && Clock::now() >= deadline) break;
+            }
+        }
+
+        // Phase 2: yield.
+        for (int i = 0; i < strategy_.yields; ++i) {
+            if (has_work()) return;
+            std::this_thread::yield();
+        }
+
+        if (!strategy_.park) {
+            // Pure spinning: never block, just keep polling.
+            while (!has_work()) cpu_pause();
+            return;
+        }
+
+        // Phase 3: park on the futex.
+        sleepers_.fetch_add(1);
+        while (true) {
+            unsigned epoch = wake_epoch_.load();
+            if (queued_.load() > 0 || stop_.load()) break;
+            wake_epoch_.wait(epoch);
+        }
+        sleepers_.fetch_sub(1);
+    }
+
+    void worker_loop() {
+        std::function<void()> task;
+        while (true) {
+            if (try_pop(task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            if (stop_.load() && queued_.load() == 0) return;
+            idle();
+        }
+    }
+
+    IdleStrategy strategy_;
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queue_mutex_;
+
+    alignas(64) std::atomic<long> queued_{0};
+    alignas(64) std::atomic<int> sleepers_{0};
+    alignas(64) std::atomic<unsigned> wake_epoch_{0};
+    std::atomic<long> wakeups_{0};
+    std::atomic<bool> stop_{false};
+};
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+constexpr size_t kThreads = 2;
+constexpr int kSamples = 5000;
+
+void spin_for(std::chrono::nanoseconds d) {
+    auto end = Clock::now() + d;
+    while (Clock::now() < end) {
+    }
+}
+
+// Enqueue one task at a time with a random 1-30 us gap and record how long
+// each task waited between enqueue() and the first instruction it ran.
+template <typename Pool>
+std::vector<double> measure_latency(Pool& pool) {
+    std::vector<double> latencies_us(kSamples);
+    std::atomic<int> done{0};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> gap_us(1, 30);
+
+    for (int i = 0; i < kSamples; ++i) {
+        auto enqueued = Clock::now();
+        pool.enqueue([&latencies_us, &done, enqueued, i] {
+            latencies_us[i] = std::chrono::duration<double, std::micro>(
+                Clock::now() - enqueued).count();
+            done.fetch_add(1, std::memory_order_release);
+        });
+        spin_for(std::chrono::microseconds(gap_us(rng)));
+    }
+    while (done.load(std::memory_order_acquire) < kSamples) {
+        std::this_thread::yield();
+    }
+    std::sort(latencies_us.begin(), latencies_us.end());
+    return latencies_us;
+}
+
+void report(const char* name, const std::vector<double>& sorted, long wakeups) {
+    auto pct = [&](double p) { return sorted[static_cast<size_t>(p * (sorted.size() - 1))]; };
+    std::cout << "  " << std::left << std::setw(18) << name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(10) << pct(0.50)
+              << std::setw(10) << pct(0.99);
+    if (wakeups >= 0) {
+        std::cout << std::setw(10) << wakeups;
+    } else {
+        std::cout << std::setw(10) << "-";
+    }
+    std::cout << "\n";
+}
+
+int main() {
+    std::cout << "Dispatch latency, " << kSamples << " tasks, " << kThreads
+              << " workers, 1-30 us gaps between tasks\n\n";
+    std::cout << "  " << std::left << std::setw(18) << "strategy" << std::right
+              << std::setw(10) << "p50 (us)" << std::setw(10) << "p99 (us)"
+              << std::setw(10) << "wakeups" << "\n";
+
+    {
+        ThreadPool pool(kThreads);
+        report("condvar (old)", measure_latency(pool), -1);
+    }
+
+    for (auto strategy : {IdleStrategy::park_immediately(),
+                          IdleStrategy::spin_then_park(),
+                          IdleStrategy::spin_only()}) {
+        SpinParkThreadPool pool(kThreads, strategy);
+        auto latencies = measure_latency(pool);
+        report(strategy.name, latencies, pool.wakeups());
+    }
+
+    std::cout << "\nNote: spinning only helps when there are spare cores. With\n"
+              << "more runnable threads than cores, spinners steal CPU from\n"
+              << "the producer and latency gets worse, not better.\n";
+    return 0;
+}
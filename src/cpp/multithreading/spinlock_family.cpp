@@ -0,0 +1,352 @@
+/**
+ * Scalable Spinlocks: TTAS + Backoff, Ticket, MCS and CLH
+ *
+ * Spinlock (spinlock.cpp) spins on test_and_set: every waiter performs an
+ * atomic read-modify-write on the same cache line in a tight loop. Each RMW
+ * pulls the line into that core's cache in exclusive state, so with N
+ * waiters the line ping-pongs between N cores and the lock holder's own
+ * unlock has to wait its turn. Throughput collapses as threads are added.
+ *
+ * Four classic fixes, all with the same lock() / unlock() interface (so
+ * they work with std::lock_guard and std::unique_lock); all but CLHLock
+ * also have try_lock(), which std::scoped_lock needs for several locks:
+ *
+ *   TTASLock    test-and-test-and-set: spin on a plain load (the line stays
+ *               shared in every waiter's cache), only try the exchange when
+ *               the lock looks free; back off exponentially after a failed
+ *               attempt so waiters don't all rush in together
+ *   TicketLock  take a number, wait until it is served. FIFO-fair; all
+ *               waiters still read one shared counter
+ *   MCSLock     queue lock: each waiter spins on a flag in its OWN queue
+ *               node, and unlock hands the lock to the next node directly.
+ *               One cache-line transfer per handoff, regardless of waiters
+ *   CLHLock     queue lock where each waiter spins on its predecessor's
+ *               node instead of its own; simpler unlock than MCS
+ *
+ * Queue nodes for MCS and CLH come from a small per-thread cache, so
+ * the plain lock()/unlock() interface works, including for nested locks.
+ *
+ * Spinlock is spinlock.cpp's, unchanged apart from try_lock(). The four
+ * new locks spin with the PAUSE hint and yield the CPU after a while:
+ * FIFO locks hand the lock to a specific waiter, and when threads outnumber
+ * cores that waiter may be descheduled, so pure spinning would stall.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread spinlock_family.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#endif
+}
+
+// Spin politely: PAUSE every iteration, give up the CPU every 128.
+inline void spin_wait(unsigned& spins) {
+    if (++spins % 128 == 0) {
+        std::this_thread::yield();
+    } else {
+        cpu_relax();
+    }
+}
+
+// ─── Baseline: spinlock.cpp's Spinlock (plus try_lock) ───────────────────────
+
+class Spinlock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            cpu_relax();
+        }
+    }
+
+    bool try_lock() noexcept {
+        return !flag_.test_and_set(std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+// ─── TTAS with exponential backoff ───────────────────────────────────────────
+
+class TTASLock {
+public:
+    void lock() noexcept {
+        unsigned backoff = 1;
+        unsigned spins = 0;
+        while (true) {
+            // Read-only spin: no cache-line ping-pong while the lock is held.
+            while (locked_.load(std::memory_order_relaxed)) spin_wait(spins);
+            if (!locked_.exchange(true, std::memory_order_acquire)) return;
+
+            // Lost the race: wait a growing, bounded number of pauses.
+            for (unsigned i = 0; i < backoff; ++i) cpu_relax();
+            if (backoff < kMaxBackoff) backoff <<= 1;
+        }
+    }
+
+    bool try_lock() noexcept {
+        return !locked_.load(std::memory_order_relaxed) &&
+               !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+    static constexpr unsigned kMaxBackoff = 1024;
+    std::atomic<bool> locked_{false};
+};
+
+// ─── Ticket lock ─────────────────────────────────────────────────────────────
+
+class TicketLock {
+public:
+    void lock() noexcept {
+        uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        unsigned spins = 0;
+        while (serving_.load(std::memory_order_acquire) != ticket) spin_wait(spins);
+    }
+
+    bool try_lock() noexcept {
+        uint32_t serving = serving_.load(std::memory_order_acquire);
+        uint32_t expected = serving;
+        // Only take a ticket if it would be served immediately.
+        return next_.compare_exchange_strong(expected, serving + 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept {
+        // Only the holder writes serving_, so a plain increment is enough.
+        serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    // Separate lines: arriving threads bump next_ without disturbing the
+    // line that waiters poll.
+    alignas(64) std::atomic<uint32_t> next_{0};
+    alignas(64) std::atomic<uint32_t> serving_{0};
+};
+
+// ─── Per-thread queue node cache (MCS / CLH) ─────────────────────────────────
+
+// A thread owns the nodes in its cache and deletes them when it exits.
+// MCS nodes always come back to the thread that took them; CLH nodes change
+// hands (see CLHLock::unlock), but every node has exactly one owner.
+template <typename Node>
+class NodeCache {
+public:
+    static Node* take() {
+        auto& spares = instance().spares_;
+        if (spares.empty()) return new Node;
+        Node* node = spares.back();
+        spares.pop_back();
+        return node;
+    }
+
+    static void give(Node* node) { instance().spares_.push_back(node); }
+
+private:
+    ~NodeCache() {
+        for (Node* node : spares_) delete node;
+    }
+
+    static NodeCache& instance() {
+        thread_local NodeCache cache;
+        return cache;
+    }
+
+    std::vector<Node*> spares_;
+};
+
+// ─── MCS lock ────────────────────────────────────────────────────────────────
+
+class MCSLock {
+public:
+    void lock() noexcept {
+        QNode* node = NodeCache<QNode>::take();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+
+        QNode* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        if (pred) {
+            pred->next.store(node, std::memory_order_release);
+            unsigned spins = 0;
+            while (node->locked.load(std::memory_order_acquire)) spin_wait(spins);
+        }
+        holder_ = node;
+    }
+
+    bool try_lock() noexcept {
+        QNode* node = NodeCache<QNode>::take();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        QNode* expected = nullptr;
+        if (tail_.compare_exchange_strong(expected, node, std::memory_order_acq_rel)) {
+            holder_ = node;
+            return true;
+        }
+        NodeCache<QNode>::give(node);
+        return false;
+    }
+
+    void unlock() noexcept {
+        QNode* node = holder_;
+        QNode* succ = node->next.load(std::memory_order_acquire);
+        if (!succ) {
+            // No visible successor: try to swing tail back to empty.
+            QNode* expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                NodeCache<QNode>::give(node);
+                return;
+            }
+            // A successor swapped itself in but hasn't linked yet.
+            unsigned spins = 0;
+            while (!(succ = node->next.load(std::memory_order_acquire))) spin_wait(spins);
+        }
+        succ->locked.store(false, std::memory_order_release);
+        NodeCache<QNode>::give(node);
+    }
+
+private:
+    struct alignas(64) QNode {
+        std::atomic<QNode*> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(64) std::atomic<QNode*> tail_{nullptr};
+    QNode* holder_ = nullptr;  // written and read only by the lock holder
+};
+
+// ─── CLH lock ────────────────────────────────────────────────────────────────
+
+// No try_lock(): a CAS on tail_ would be open to ABA. Between reading an
+// unlocked tail and the CAS, another thread can unlock (recycling that node
+// into its cache) and lock again with the same node, and the CAS would then
+// succeed on a held lock.
+class CLHLock {
+public:
+    CLHLock() : tail_(new QNode) {}
+    ~CLHLock() { delete tail_.load(); }
+
+    CLHLock(const CLHLock&) = delete;
+    CLHLock& operator=(const CLHLock&) = delete;
+
+    void lock() noexcept {
+        QNode* node = NodeCache<QNode>::take();
+        node->locked.store(true, std::memory_order_relaxed);
+        QNode* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        unsigned spins = 0;
+        while (pred->locked.load(std::memory_order_acquire)) spin_wait(spins);
+        holder_ = node;
+        holder_pred_ = pred;
+    }
+
+    void unlock() noexcept {
+        QNode* node = holder_;
+        QNode* pred = holder_pred_;
+        // From here our node belongs to the queue: the successor spinning on
+        // it will take it over (or it stays as tail_). Nobody references the
+        // predecessor's node any more, so it becomes ours.
+        node->locked.store(false, std::memory_order_release);
+        NodeCache<QNode>::give(pred);
+    }
+
+private:
+    struct alignas(64) QNode {
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(64) std::atomic<QNode*> tail_;
+    QNode* holder_ = nullptr;
+    QNode* holder_pred_ = nullptr;
+};
+
+// ─── Benchmark (spinlock.cpp's benchmark_ms, swept over thread counts) ───────
+
+template <typename F>
+long benchmark_ms(F&& func, int num_threads) {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_threads; ++i) threads.emplace_back(func);
+    for (auto& t : threads) t.join();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+constexpr int kIterations = 200'000;
+
+// Time kIterations lock/++counter/unlock per thread; checks the total.
+template <typename Lock>
+long run_lock(int num_threads, bool& correct) {
+    Lock lock;
+    long counter = 0;
+    long ms = benchmark_ms([&] {
+        for (int i = 0; i < kIterations; ++i) {
+            std::lock_guard<Lock> guard(lock);
+            ++counter;
+        }
+    }, num_threads);
+    correct = correct && counter == static_cast<long>(kIterations) * num_threads;
+    return ms;
+}
+
+template <typename Lock>
+void sweep(const char* name, const std::vector<int>& thread_counts) {
+    bool correct = true;
+    std::cout << std::left << std::setw(12) << name << std::right;
+    for (int n : thread_counts) {
+        std::cout << std::setw(9) << run_lock<Lock>(n, correct);
+    }
+    std::cout << (correct ? "" : "   WRONG COUNT") << "\n";
+}
+
+int main() {
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores == 0) cores = 2;
+
+    // 1, 2, 4, ... up to cores, then 2 x cores (oversubscribed).
+    std::vector<int> thread_counts;
+    for (int n = 1; n < cores; n *= 2) thread_counts.push_back(n);
+    thread_counts.push_back(cores);
+    thread_counts.push_back(2 * cores);
+
+    std::cout << "Cores: " << cores << ", " << kIterations
+              << " lock/unlock per thread, time in ms\n\n";
+    std::cout << std::left << std::setw(12) << "threads" << std::right;
+    for (int n : thread_counts) std::cout << std::setw(9) << n;
+    std::cout << "\n";
+
+    sweep<Spinlock>("Spinlock", thread_counts);
+    sweep<TTASLock>("TTAS", thread_counts);
+    sweep<TicketLock>("Ticket", thread_counts);
+    sweep<MCSLock>("MCS", thread_counts);
+    sweep<CLHLock>("CLH", thread_counts);
+    sweep<std::mutex>("std::mutex", thread_counts);
+
+    // try_lock and nesting work through the common interface.
+    MCSLock outer;
+    TicketLock inner;
+    std::scoped_lock both(outer, inner);  // uses try_lock to avoid deadlock
+
+    std::cout << "\nNote: TTAS should hold up better than Spinlock as threads grow; the\n"
+              << "queue locks (MCS, CLH) scale best while threads <= cores. Past that,\n"
+              << "every FIFO handoff may target a descheduled thread, which is why the\n"
+              << "fair locks suffer most in the oversubscribed column.\n";
+    return 0;
+}
@@ -0,0 +1,480 @@
+/**
+ * Task Tracing with Chrome Trace Event / Perfetto Export
+ *
+ * Totals and averages tell you that something stalled, not where or why.
+ * A timeline of every task - when it was queued, when a worker picked it
+ * up, when it finished - shows queueing delays, idle workers and the
+ * fork/join shape of recursive algorithms directly.
+ *
+ * This example adds an optional tracing layer:
+ * - Each thread records events into its own fixed-size ring buffer. Only
+ *   the owning thread writes, so recording is a few plain stores plus one
+ *   release store of the head index: no locks, no atomics RMW, no
+ *   allocation after the first event on a thread.
+ * - When a buffer is full the oldest events are overwritten, so tracing
+ *   can be left running and still keeps the most recent history. The
+ *   exporter drops what the wrap orphaned: "E" events whose "B" was
+ *   overwritten, and flow arrows whose start is gone.
+ * - Tracer::write_chrome_trace() dumps all buffers as Chrome Trace Event
+ *   JSON, which opens in chrome://tracing and https://ui.perfetto.dev.
+ * - Tracing is off until Tracer::enable() is called; a disabled hook costs
+ *   a single relaxed load. Compile with -DTASK_TRACING=0 to remove the
+ *   hooks entirely: TRACE_EVENT, TRACE_NEW_FLOW and TRACE_THREAD_NAME then
+ *   expand to nothing (or 0) and never touch the Tracer.
+ *
+ * Hooks are added to three existing examples:
+ * - ThreadPool (thread_pool.cpp): enqueue, start and end of every task,
+ *   with flow arrows linking each enqueue to the worker that ran it
+ * - Scheduler (scheduler.cpp): one slice per periodic run
+ * - parallel_sort (merge_sort.cpp): one slice per recursive call, so the
+ *   fork/join tree is visible level by level
+ *
+ * A work-stealing pool (work_stealing_thread_pool.cpp) would record an
+ * Instant named "steal" with the task's flow id when a thief takes it; the
+ * exporter draws the arrow from any Instant with a flow to the Begin that
+ * carries the same id.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread task_tracing.cpp
+ * Run, then open trace.json in https://ui.perfetto.dev
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifndef TASK_TRACING
+#define TASK_TRACING 1
+#endif
+
+// ─── Tracer ──────────────────────────────────────────────────────────────────
+
+enum class EventKind : char {
+    Begin,    // "B": slice starts on this thread
+    End,      // "E": slice ends on this thread
+    Instant,  // "i": point event, e.g. enqueue
+};
+
+struct TraceEvent {
+    std::uint64_t ts_ns;
+    const char* name;    // must be a string literal (stored by pointer)
+    EventKind kind;
+    std::uint64_t flow;  // 0 = none; links an enqueue to the task's start
+    std::int64_t arg0;
+    std::int64_t arg1;
+};
+
+class ThreadTraceBuffer {
+public:
+    static constexpr std::size_t kCapacity = 1 << 16;  // power of two
+
+    ThreadTraceBuffer(int tid, std::string name)
+        : tid_(tid), name_(std::move(name)), events_(kCapacity) {}
+
+    // Owner thread only.
+    void record(const TraceEvent& e) {
+        std::size_t h = head_.load(std::memory_order_relaxed);
+        events_[h & (kCapacity - 1)] = e;
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    // Reader: the last min(head, capacity) events, oldest first. Intended to
+    // run after the traced work has finished.
+    template <typename F>
+    void for_each(F&& f) const {
+        std::size_t h = head_.load(std::memory_order_acquire);
+        std::size_t first = h > kCapacity ? h - kCapacity : 0;
+        for (std::size_t i = first; i < h; ++i) f(events_[i & (kCapacity - 1)]);
+    }
+
+    int tid() const { return tid_; }
+    const std::string& name() const { return name_; }
+
+private:
+    int tid_;
+    std::string name_;
+    std::vector<TraceEvent> events_;
+    std::atomic<std::size_t> head_{0};
+};
+
+class Tracer {
+public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void enable() { enabled_.store(true, std::memory_order_relaxed); }
+    void disable() { enabled_.store(false, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Label the calling thread in the trace viewer. Call before its first event.
+    void set_thread_name(std::string name) { thread_name() = std::move(name); }
+
+    std::uint64_t new_flow_id() { return next_flow_.fetch_add(1, std::memory_order_relaxed); }
+
+    void record(EventKind kind, const char* name, std::uint64_t flow = 0,
+                std::int64_t arg0 = -1, std::int64_t arg1 = -1) {
+        if (!enabled()) return;
+        local_buffer().record({now_ns(), name, kind, flow, arg0, arg1});
+    }
+
+    bool write_chrome_trace(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+        {
+            std::scoped_lock lock(mutex_);
+            buffers = buffers_;
+        }
+
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        auto sep = [&] {
+            if (!first) out << ",\n";
+            first = false;
+        };
+
+        // Flow starts that survived the ring buffers; an arrow is only
+        // finished if its start is exported too.
+        std::unordered_set<std::uint64_t> flow_starts;
+        for (const auto& buf : buffers) {
+            buf->for_each([&](const TraceEvent& e) {
+                if (e.flow != 0 && e.kind == EventKind::Instant) flow_starts.insert(e.flow);
+            });
+        }
+
+        for (const auto& buf : buffers) {
+            sep();
+            out << R"({"ph":"M","pid":1,"tid":)" << buf->tid()
+                << R"(,"name":"thread_name","args":{"name":")" << buf->name() << "\"}}";
+
+            int open = 0;  // Begins without their End yet, on this thread
+            buf->for_each([&](const TraceEvent& e) {
+                // After a wrap the oldest Ends may have lost their Begins.
+                if (e.kind == EventKind::End && open == 0) return;
+                if (e.kind == EventKind::Begin) ++open;
+                if (e.kind == EventKind::End) --open;
+
+                double ts_us = static_cast<double>(e.ts_ns) / 1000.0;
+                sep();
+                out << "{\"pid\":1,\"tid\":" << buf->tid() << ",\"ts\":" << std::fixed << ts_us
+                    << ",\"name\":\"" << e.name << "\",\"cat\":\"task\",";
+                switch (e.kind) {
+                    case EventKind::Begin:   out << "\"ph\":\"B\""; break;
+                    case EventKind::End:     out << "\"ph\":\"E\""; break;
+                    case EventKind::Instant: out << "\"ph\":\"i\",\"s\":\"t\""; break;
+                }
+                if (e.arg0 >= 0 || e.arg1 >= 0) {
+                    out << ",\"args\":{\"a\":" << e.arg0 << ",\"b\":" << e.arg1 << "}";
+                }
+                out << "}";
+
+                // Flow arrows: start at the enqueue, finish at the slice begin.
+                bool flow_start = e.kind == EventKind::Instant;
+                bool flow_end = e.kind == EventKind::Begin && flow_starts.count(e.flow) != 0;
+                if (e.flow != 0 && (flow_start || flow_end)) {
+                    sep();
+                    out << "{\"pid\":1,\"tid\":" << buf->tid() << ",\"ts\":" << ts_us
+                        << ",\"name\":\"dispatch\",\"cat\":\"flow\",\"id\":" << e.flow
+                        << (e.kind == EventKind::Instant ? ",\"ph\":\"s\"}"
+                                                         : ",\"ph\":\"f\",\"bp\":\"e\"}");
+                }
+            });
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+
+private:
+    Tracer() : epoch_(std::chrono::steady_clock::now()) {}
+
+    std::uint64_t now_ns() const {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch_).count());
+    }
+
+    static std::string& thread_name() {
+        thread_local std::string name;
+        return name;
+    }
+
+    // Registered once per thread; shared ownership keeps the events around
+    // after the thread exits.
+    ThreadTraceBuffer& local_buffer() {
+        thread_local std::shared_ptr<ThreadTraceBuffer> buffer = [this] {
+            std::scoped_lock lock(mutex_);
+            int tid = static_cast<int>(buffers_.size()) + 1;
+            std::string name = thread_name().empty() ? "thread " + std::to_string(tid)
+                                                     : thread_name();
+            buffers_.push_back(std::make_shared<ThreadTraceBuffer>(tid, name));
+            return buffers_.back();
+        }();
+        return *buffer;
+    }
+
+    std::chrono::steady_clock::time_point epoch_;
+    std::atomic<bool> enabled_{false};
+    std::atomic<std::uint64_t> next_flow_{1};
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers_;
+};
+
+#if TASK_TRACING
+#define TRACE_EVENT(...) Tracer::instance().record(__VA_ARGS__)
+#define TRACE_NEW_FLOW() (Tracer::instance().enabled() ? Tracer::instance().new_flow_id() : 0)
+#define TRACE_THREAD_NAME(name) Tracer::instance().set_thread_name(name)
+#else
+// Unevaluated: the arguments are still type-checked, but nothing runs.
+#define TRACE_EVENT(...) ((void)sizeof(Tracer::instance().record(__VA_ARGS__), 0))
+#define TRACE_NEW_FLOW() std::uint64_t{0}
+#define TRACE_THREAD_NAME(name) ((void)sizeof(Tracer::instance().set_thread_name(name), 0))
+#endif
+
+// RAII slice: Begin on construction, End on destruction.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, std::int64_t arg0 = -1, std::int64_t arg1 = -1,
+                        std::uint64_t flow = 0)
+        : name_(name) {
+        TRACE_EVENT(EventKind::Begin, name, flow, arg0, arg1);
+    }
+    ~TraceScope() { TRACE_EVENT(EventKind::End, name_); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    [[maybe_unused]] const char* name_;
+};
+
+// ─── ThreadPool (thread_pool.cpp) with trace hooks ───────────────────────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        std::uint64_t flow = TRACE_NEW_FLOW();
+        TRACE_EVENT(EventKind::Instant, "enqueue", flow);
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push({std::move(task), flow});
+        }
+        cv_.notify_one();
+    }
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        std::uint64_t flow;
+    };
+
+    void worker_loop(size_t index) {
+        TRACE_THREAD_NAME("pool worker " + std::to_string(index));
+        while (true) {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                job = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            TraceScope scope("task", -1, -1, job.flow);
+            job.fn();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<Job> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// ─── Scheduler (scheduler.cpp) with trace hooks ──────────────────────────────
+
+class Scheduler {
+public:
+    Scheduler(std::chrono::milliseconds interval, std::function<void()> task)
+        : running_(true),
+          interval_(interval),
+          task_(std::move(task)) {
+        worker_ = std::thread([this] {
+            TRACE_THREAD_NAME("scheduler");
+            int64_t run = 0;
+            while (running_) {
+                {
+                    TraceScope scope("scheduled run", run++);
+                    task_();
+                }
+                std::this_thread::sleep_for(interval_);
+            }
+        });
+    }
+
+    ~Scheduler() {
+        stop();
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    void stop() {
+        running_ = false;
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+private:
+    std::atomic<bool> running_;
+    std::chrono::milliseconds interval_;
+    std::function<void()> task_;
+    std::thread worker_;
+};
+
+// ─── parallel_sort (merge_sort.cpp) with trace hooks ─────────────────────────
+
+void merge(std::vector<int>& arr, int left, int mid, int right) {
+    std::vector<int> temp(right - left + 1);
+    int i = left, j = mid + 1, k = 0;
+
+    while (i <= mid && j <= right) {
+        if (arr[i] <= arr[j]) {
+            temp[k++] = arr[i++];
+        } else {
+            temp[k++] = arr[j++];
+        }
+    }
+
+    while (i <= mid) temp[k++] = arr[i++];
+    while (j <= right) temp[k++] = arr[j++];
+
+    std::copy(temp.begin(), temp.end(), arr.begin() + left);
+}
+
+void sequential_sort(std::vector<int>& arr, int left, int right) {
+    if (left < right) {
+        int mid = left + (right - left) / 2;
+        sequential_sort(arr, left, mid);
+        sequential_sort(arr, mid + 1, right);
+        merge(arr, left, mid, right);
+    }
+}
+
+// Slices are named by phase; args a/b are the [left, right] range.
+void parallel_sort(std::vector<int>& arr, int left, int right, int depth = 0) {
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores == 0) cores = 2;
+    int max_depth = std::max(2, static_cast<int>(std::log2(cores)));
+
+    if (left >= right) return;
+
+    TraceScope scope("parallel_sort", left, right);
+    int mid = left + (right - left) / 2;
+
+    if (depth < max_depth) {
+        std::uint64_t flow = TRACE_NEW_FLOW();
+        TRACE_EVENT(EventKind::Instant, "fork", flow, left, mid);
+        std::thread left_thread([&arr, left, mid, depth, flow] {
+            TRACE_THREAD_NAME("sort depth " + std::to_string(depth + 1));
+            TraceScope forked("forked half", left, mid, flow);
+            parallel_sort(arr, left, mid, depth + 1);
+        });
+        parallel_sort(arr, mid + 1, right, depth + 1);
+        left_thread.join();
+    } else {
+        TraceScope leaf("sequential_sort", left, right);
+        sequential_sort(arr, left, mid);
+        sequential_sort(arr, mid + 1, right);
+    }
+
+    TraceScope join("merge", left, right);
+    merge(arr, left, mid, right);
+}
+
+// ─── Demo ────────────────────────────────────────────────────────────────────
+
+void spin_for(std::chrono::microseconds d) {
+    auto end = std::chrono::steady_clock::now() + d;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+int main() {
+    Tracer::instance().set_thread_name("main");
+    Tracer::instance().enable();
+
+    {
+        Scheduler scheduler(std::chrono::milliseconds(5), [] {
+            spin_for(std::chrono::microseconds(300));
+        });
+
+        {
+            ThreadPool pool(4);
+            for (int i = 0; i < 200; ++i) {
+                pool.enqueue([i] { spin_for(std::chrono::microseconds(50 + (i % 7) * 40)); });
+            }
+        }
+
+        std::vector<int> data(200000);
+        for (auto& x : data) x = rand();
+        parallel_sort(data, 0, static_cast<int>(data.size()) - 1);
+        std::cout << "Sorted: " << std::boolalpha
+                  << std::is_sorted(data.begin(), data.end()) << "\n";
+    }
+
+    Tracer::instance().disable();
+    if (Tracer::instance().write_chrome_trace("trace.json")) {
+        std::cout << "Wrote trace.json - open it in https://ui.perfetto.dev "
+                  << "or chrome://tracing\n";
+    } else {
+        std::cerr << "Failed to write trace.json\n";
+        return 1;
+    }
+    return 0;
+}
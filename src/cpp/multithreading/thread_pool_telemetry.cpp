@@ -0,0 +1,606 @@
+/**
+ * Thread Pool Telemetry: Queue-Wait and Run-Time Histograms
+ *
+ * The pools in thread_pool.cpp and thread_pool_futures.cpp expose nothing
+ * about how they behave: how long tasks sit in the queue, how long they
+ * run, or how busy the workers are. Without that, pool sizing is guesswork.
+ *
+ * This example adds built-in telemetry to both pool flavours:
+ * - Per-worker counters (tasks run, CPU time), each on its own cache line
+ * - Per-worker log-linear latency histograms for enqueue -> start (queue
+ *   wait) and start -> finish (run time). Buckets are powers of two split
+ *   into 8 linear sub-buckets, so relative error is bounded at 12.5% over
+ *   the full 64-bit range with only 512 counters.
+ * - Each histogram has exactly one writer (its worker), so recording is a
+ *   relaxed load + store, no atomic read-modify-write and no lock.
+ * - stats() merges all workers' histograms on read and returns a snapshot
+ *   with percentiles and utilisation.
+ *
+ * Timestamps use the CPU timestamp counter where available, calibrated once
+ * against std::chrono::steady_clock. Even so, three timestamps per task are
+ * several percent of a 1 us task, so only one task in
+ * 2^POOL_TELEMETRY_SAMPLE_SHIFT (default 1 in 16) is timed, and the
+ * histograms hold that sample:
+ * - run time: each worker times every 16th task it runs, off the same
+ *   per-worker counter that counts its tasks, so the only per-task cost on
+ *   the worker is that counter
+ * - queue wait: each producer stamps every 16th task it enqueues (a
+ *   thread_local counter); the worker records start - stamp. TSC values
+ *   from two cores may be slightly out of step, so a negative wait
+ *   counts as 0.
+ * Set the shift to 0 to time every task.
+ *
+ * Utilisation is the worker thread's CPU time (CLOCK_THREAD_CPUTIME via
+ * pthread_getcpuclockid, read only when stats() is called) over the pool's
+ * uptime, so a task that is preempted while running is not counted as
+ * busy. Without a per-thread CPU clock it falls back to an estimate: the
+ * mean sampled run time times the task count, capped at 100%.
+ *
+ * Telemetry is a template parameter, so a pool built with
+ * Telemetry = false contains no telemetry code or data at all. The default
+ * follows the POOL_TELEMETRY macro: compile with -DPOOL_TELEMETRY=0 to turn
+ * it off everywhere.
+ *
+ * The benchmark runs 1 us tasks through both pools with telemetry on and
+ * off. End to end, scheduling noise is several % on a small machine, so
+ * the 2% budget is checked separately: the telemetry calls are timed
+ * around an empty task on one thread, and that per-task cost is compared
+ * with 1 us. Finally it prints a stats() snapshot.
+ *
+ * Compile: g++ -std=c++20 -O2 -pthread thread_pool_telemetry.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef POOL_TELEMETRY
+#define POOL_TELEMETRY 1
+#endif
+
+#ifndef POOL_TELEMETRY_SAMPLE_SHIFT
+#define POOL_TELEMETRY_SAMPLE_SHIFT 4
+#endif
+
+// ─── Cheap timestamps ────────────────────────────────────────────────────────
+
+namespace tick {
+
+inline std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Nanoseconds per tick, measured once on first use.
+inline double ns_per_tick() {
+    static const double value = [] {
+        auto t0 = std::chrono::steady_clock::now();
+        std::uint64_t c0 = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto t1 = std::chrono::steady_clock::now();
+        std::uint64_t c1 = now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return c1 > c0 ? ns / static_cast<double>(c1 - c0) : 1.0;
+    }();
+    return value;
+}
+
+}  // namespace tick
+
+// ─── Log-linear histogram ────────────────────────────────────────────────────
+
+class HistogramSnapshot;
+
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kBuckets = 64 * kSubBuckets;
+
+    static int bucket_for(std::uint64_t v) {
+        if (v < kSubBuckets) return static_cast<int>(v);
+        int exp = 63 - __builtin_clzll(v);
+        int sub = static_cast<int>((v >> (exp - kSubBits)) & (kSubBuckets - 1));
+        return (exp - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    static std::uint64_t lower_bound(int bucket) {
+        if (bucket < kSubBuckets) return static_cast<std::uint64_t>(bucket);
+        int exp = bucket / kSubBuckets + kSubBits - 1;
+        std::uint64_t sub = static_cast<std::uint64_t>(bucket % kSubBuckets);
+        return (std::uint64_t{1} << exp) + (sub << (exp - kSubBits));
+    }
+
+    // Single writer only: the owning worker.
+    void record(std::uint64_t value_ns) {
+        bump(buckets_[bucket_for(value_ns)], 1);
+        bump(count_, 1);
+        bump(sum_, value_ns);
+        if (value_ns > max_.load(std::memory_order_relaxed)) {
+            max_.store(value_ns, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    friend class HistogramSnapshot;
+
+    static void bump(std::atomic<std::uint64_t>& a, std::uint64_t by) {
+        a.store(a.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+class HistogramSnapshot {
+public:
+    void merge(const LatencyHistogram& h) {
+        for (int i = 0; i < LatencyHistogram::kBuckets; ++i) {
+            buckets_[i] += h.buckets_[i].load(std::memory_order_relaxed);
+        }
+        count_ += h.count_.load(std::memory_order_relaxed);
+        sum_ += h.sum_.load(std::memory_order_relaxed);
+        max_ = std::max(max_, h.max_.load(std::memory_order_relaxed));
+    }
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t max_ns() const { return max_; }
+    double mean_ns() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    // Lower bound of the bucket holding the p-th quantile (0 <= p <= 1).
+    std::uint64_t percentile_ns(double p) const {
+        if (count_ == 0) return 0;
+        auto rank = static_cast<std::uint64_t>(p * static_cast<double>(count_ - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (int i = 0; i < LatencyHistogram::kBuckets; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) return LatencyHistogram::lower_bound(i);
+        }
+        return max_;
+    }
+
+private:
+    std::array<std::uint64_t, LatencyHistogram::kBuckets> buckets_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+// ─── Telemetry shared by both pools ──────────────────────────────────────────
+
+struct WorkerStats {
+    std::uint64_t tasks;
+    std::uint64_t busy_ns;  // thread CPU time, or an estimate (see header)
+    double utilisation;     // busy time / pool lifetime
+};
+
+struct PoolStats {
+    bool enabled = false;
+    double uptime_ms = 0;
+    std::vector<WorkerStats> workers;
+    HistogramSnapshot queue_wait;
+    HistogramSnapshot run_time;
+};
+
+struct alignas(64) WorkerTelemetry {
+    std::atomic<std::uint64_t> tasks{0};  // also the worker's sampling counter
+#ifdef __linux__
+    std::atomic<bool> has_cpu_clock{false};
+    clockid_t cpu_clock{};
+#endif
+    LatencyHistogram queue_wait;
+    LatencyHistogram run_time;
+};
+
+template <bool Enabled>
+class PoolTelemetry {
+public:
+    using Stamp = std::uint64_t;  // 0 = task not sampled
+
+    static constexpr unsigned kSampleMask = (1u << POOL_TELEMETRY_SAMPLE_SHIFT) - 1;
+
+    explicit PoolTelemetry(size_t workers)
+        : ns_per_tick_(tick::ns_per_tick()), started_(tick::now()) {
+        for (size_t i = 0; i < workers; ++i) {
+            workers_.push_back(std::make_unique<WorkerTelemetry>());
+        }
+    }
+
+    // Called on enqueue. Queue-wait sampling is decided per producer thread
+    // so that no shared counter is needed.
+    static Stamp enqueue_stamp() {
+        thread_local unsigned counter = 0;
+        return (counter++ & kSampleMask) == 0 ? tick::now() : 0;
+    }
+
+    // Called once by each worker thread before its first task.
+    void register_worker(size_t worker) {
+#ifdef __linux__
+        WorkerTelemetry& w = *workers_[worker];
+        if (pthread_getcpuclockid(pthread_self(), &w.cpu_clock) == 0) {
+            w.has_cpu_clock.store(true, std::memory_order_release);
+        }
+#else
+        (void)worker;
+#endif
+    }
+
+    // Run a dequeued task. Every 16th task of this worker is timed; the
+    // queue wait is recorded if the producer stamped the task.
+    template <typename F>
+    void run(size_t worker, Stamp enqueued, F&& fn) {
+        WorkerTelemetry& w = *workers_[worker];
+        std::uint64_t n = w.tasks.load(std::memory_order_relaxed);
+        w.tasks.store(n + 1, std::memory_order_relaxed);
+        bool time_run = (n & kSampleMask) == 0;
+        if (!time_run && enqueued == 0) {
+            fn();
+            return;
+        }
+        Stamp start = tick::now();
+        if (enqueued != 0) w.queue_wait.record(elapsed_ns(enqueued, start));
+        fn();
+        if (time_run) w.run_time.record(elapsed_ns(start, tick::now()));
+    }
+
+    PoolStats snapshot() const {
+        PoolStats stats;
+        stats.enabled = true;
+        double uptime_ns = static_cast<double>(elapsed_ns(started_, tick::now()));
+        stats.uptime_ms = uptime_ns / 1e6;
+        for (const auto& w : workers_) {
+            std::uint64_t tasks = w->tasks.load(std::memory_order_relaxed);
+            HistogramSnapshot run_time;
+            run_time.merge(w->run_time);
+            double busy = busy_ns(*w, tasks, run_time);
+            stats.workers.push_back({tasks, static_cast<std::uint64_t>(busy),
+                                     uptime_ns > 0 ? std::min(busy / uptime_ns, 1.0) : 0.0});
+            stats.queue_wait.merge(w->queue_wait);
+            stats.run_time.merge(w->run_time);
+        }
+        return stats;
+    }
+
+private:
+    // Thread CPU time where available, else mean sampled run time x tasks.
+    static double busy_ns(const WorkerTelemetry& w, std::uint64_t tasks, const HistogramSnapshot& run_time) {
+#ifdef __linux__
+        timespec ts;
+        if (w.has_cpu_clock.load(std::memory_order_acquire) && clock_gettime(w.cpu_clock, &ts) == 0) {
+            return static_cast<double>(ts.tv_sec) * 1e9 + static_cast<double>(ts.tv_nsec);
+        }
+#endif
+        return run_time.mean_ns() * static_cast<double>(tasks);
+    }
+
+    // Stamps may come from different cores: never let a small TSC skew
+    // wrap around to a huge unsigned value.
+    std::uint64_t elapsed_ns(Stamp from, Stamp to) const {
+        if (to <= from) return 0;
+        return static_cast<std::uint64_t>(static_cast<double>(to - from) * ns_per_tick_);
+    }
+
+    double ns_per_tick_;
+    Stamp started_;
+    std::vector<std::unique_ptr<WorkerTelemetry>> workers_;
+};
+
+// Compiled-out variant: no data, every call is a no-op.
+template <>
+class PoolTelemetry<false> {
+public:
+    struct Stamp {};
+
+    explicit PoolTelemetry(size_t) {}
+    static Stamp enqueue_stamp() { return {}; }
+    void register_worker(size_t) {}
+    template <typename F>
+    void run(size_t, Stamp, F&& fn) { fn(); }
+    PoolStats snapshot() const { return {}; }
+};
+
+// ─── ThreadPool (thread_pool.cpp) with telemetry ─────────────────────────────
+
+template <bool Telemetry = POOL_TELEMETRY>
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : telemetry_(num_threads), stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        Job job{std::move(task), telemetry_.enqueue_stamp()};
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    PoolStats stats() const { return telemetry_.snapshot(); }
+
+private:
+    using Stamp = typename PoolTelemetry<Telemetry>::Stamp;
+
+    struct Job {
+        std::function<void()> fn;
+        [[no_unique_address]] Stamp enqueued;
+    };
+
+    void worker_loop(size_t index) {
+        telemetry_.register_worker(index);
+        while (true) {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                job = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            telemetry_.run(index, job.enqueued, job.fn);
+        }
+    }
+
+    PoolTelemetry<Telemetry> telemetry_;
+    std::vector<std::thread> workers_;
+    std::queue<Job> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// ─── FuturePool (thread_pool_futures.cpp) with telemetry ─────────────────────
+
+template <bool Telemetry = POOL_TELEMETRY>
+class FuturePool {
+public:
+    explicit FuturePool(std::size_t num_threads) : telemetry_(num_threads) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~FuturePool() {
+        {
+            std::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            [func = std::forward<F>(f),
+             targs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(func), std::move(targs));
+            });
+
+        std::future<ReturnType> fut = task->get_future();
+
+        {
+            std::scoped_lock lock(mutex_);
+            if (shutdown_)
+                throw std::runtime_error("submit() called on a stopped FuturePool");
+            queue_.push({[task]() { (*task)(); }, telemetry_.enqueue_stamp()});
+        }
+        cv_.notify_one();
+
+        return fut;
+    }
+
+    PoolStats stats() const { return telemetry_.snapshot(); }
+
+private:
+    using Stamp = typename PoolTelemetry<Telemetry>::Stamp;
+
+    struct Job {
+        std::function<void()> fn;
+        [[no_unique_address]] Stamp enqueued;
+    };
+
+    void worker_loop(std::size_t index) {
+        telemetry_.register_worker(index);
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+                if (shutdown_ && queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop();
+            }
+            telemetry_.run(index, job.enqueued, job.fn);
+        }
+    }
+
+    PoolTelemetry<Telemetry>  telemetry_;
+    std::vector<std::thread>  workers_;
+    std::queue<Job>           queue_;
+    std::mutex                mutex_;
+    std::condition_variable   cv_;
+    bool                      shutdown_{false};
+};
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+constexpr size_t kThreads = 4;
+constexpr int kTasks = 200'000;
+constexpr int kRepeats = 5;
+
+void spin_for(std::chrono::nanoseconds d) {
+    auto end = std::chrono::steady_clock::now() + d;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+template <typename Pool>
+double run_enqueue_ms(Pool& pool) {
+    std::atomic<int> done{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        pool.enqueue([&done] {
+            spin_for(std::chrono::microseconds(1));
+            done.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    while (done.load(std::memory_order_relaxed) < kTasks) std::this_thread::yield();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Pool>
+double run_submit_ms(Pool& pool) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(kTasks);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        futures.push_back(pool.submit([] { spin_for(std::chrono::microseconds(1)); }));
+    }
+    for (auto& f : futures) f.get();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Best of kRepeats, alternating on/off so drift affects both equally.
+template <typename PoolOn, typename PoolOff, typename Run>
+std::pair<double, double> best_of(Run run) {
+    double on = 1e300, off = 1e300;
+    for (int r = 0; r < kRepeats; ++r) {
+        { PoolOff pool(kThreads); off = std::min(off, run(pool)); }
+        { PoolOn pool(kThreads);  on  = std::min(on, run(pool)); }
+    }
+    return {on, off};
+}
+
+// What telemetry itself adds to one task: enqueue_stamp() plus run() around
+// an empty task, on one thread. Unlike the pool runs above, this has no
+// queue, lock or scheduler in it, so it resolves a few ns per task.
+template <bool Enabled>
+double telemetry_loop_ns() {
+    constexpr int kCalls = 4'000'000;
+    PoolTelemetry<Enabled> telemetry(1);
+    volatile int sink = 0;
+    std::function<void()> task = [&sink] { sink = sink + 1; };
+    double best = 1e300;
+    for (int r = 0; r < kRepeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kCalls; ++i) telemetry.run(0, telemetry.enqueue_stamp(), task);
+        best = std::min(best, std::chrono::duration<double, std::nano>(
+                                  std::chrono::steady_clock::now() - start).count() / kCalls);
+    }
+    return best;
+}
+
+void print_stats(const char* name, const PoolStats& s) {
+    std::cout << "\n" << name << " stats() after " << std::fixed << std::setprecision(1)
+              << s.uptime_ms << " ms:\n";
+    for (size_t i = 0; i < s.workers.size(); ++i) {
+        std::cout << "  worker " << i << ": " << std::setw(7) << s.workers[i].tasks
+                  << " tasks, utilisation " << std::setprecision(0)
+                  << s.workers[i].utilisation * 100 << "%\n" << std::setprecision(1);
+    }
+    auto line = [](const char* label, const HistogramSnapshot& h) {
+        std::cout << "  " << label << " p50 " << std::setw(8) << h.percentile_ns(0.50)
+                  << " ns  p99 " << std::setw(8) << h.percentile_ns(0.99)
+                  << " ns  max " << std::setw(9) << h.max_ns() << " ns\n";
+    };
+    line("queue wait:", s.queue_wait);
+    line("run time:  ", s.run_time);
+}
+
+int main() {
+    tick::ns_per_tick();  // calibrate up front, outside the timed region
+
+    std::cout << "=== " << kTasks << " x 1 us tasks, " << kThreads
+              << " workers, best of " << kRepeats << " ===\n\n";
+
+    auto [enq_on, enq_off] = best_of<ThreadPool<true>, ThreadPool<false>>(
+        [](auto& pool) { return run_enqueue_ms(pool); });
+    auto [sub_on, sub_off] = best_of<FuturePool<true>, FuturePool<false>>(
+        [](auto& pool) { return run_submit_ms(pool); });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "ThreadPool::enqueue  off " << enq_off << " ms, on " << enq_on
+              << " ms, overhead " << (enq_on / enq_off - 1) * 100 << "%\n";
+    std::cout << "FuturePool::submit   off " << sub_off << " ms, on " << sub_on
+              << " ms, overhead " << (sub_on / sub_off - 1) * 100 << "%\n";
+    std::cout << "(end to end; scheduling alone moves these by a few % between runs)\n\n";
+
+    // The budget: telemetry's own per-task cost against a 1 us task.
+    double per_task_ns = std::max(0.0, telemetry_loop_ns<true>() - telemetry_loop_ns<false>());
+    double overhead = per_task_ns / 1000.0;
+    std::cout << std::setprecision(2) << "Telemetry cost " << per_task_ns << " ns per task = "
+              << overhead * 100 << "% of a 1 us task: "
+              << (overhead <= 0.02 ? "within" : "MISSES") << " the 2% budget\n";
+
+    {
+        ThreadPool<> pool(kThreads);
+        run_enqueue_ms(pool);
+        print_stats("ThreadPool", pool.stats());
+    }
+    {
+        FuturePool<> pool(kThreads);
+        run_submit_ms(pool);
+        print_stats("FuturePool", pool.stats());
+    }
+    return 0;
+}
@@ -0,0 +1,431 @@
+/**
+ * Work-Stealing Thread Pool
+ *
+ * The basic ThreadPool (thread_pool.cpp) routes every enqueue() and every
+ * worker pop through one mutex and one std::queue. With many workers and
+ * short tasks the pool spends most of its time fighting over that lock.
+ *
+ * A work-stealing pool removes the shared hot spot:
+ * - Each worker owns a Chase-Lev deque. The owner pushes and pops at the
+ *   bottom without taking any lock (LIFO, cache-warm).
+ * - Idle workers steal from the top of a randomly chosen victim's deque
+ *   (FIFO, oldest and usually largest pieces of work).
+ * - Submissions from outside the pool go to a shared injection queue,
+ *   which is the only mutex-protected structure left.
+ *
+ * Chase-Lev deque ("Dynamic Circular Work-Stealing Deque", 2005), using the
+ * C11 memory-order formulation from Le, Pop, Cohen and Zappa Nardelli
+ * ("Correct and Efficient Work-Stealing for Weak Memory Models", 2013).
+ *
+ * The benchmark compares the single-queue pool and the stealing pool for
+ * 100 ns / 1 us / 10 us tasks at 1..N threads. Each root task fans out
+ * child tasks from inside the pool, which is where stealing pays off:
+ * children land in the local deque instead of the global queue.
+ *
+ * Compile: g++ -std=c++17 -O2 -pthread work_stealing_thread_pool.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using Task = std::function<void()>;
+
+// ─── Baseline: single shared queue (same design as thread_pool.cpp) ──────────
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : stop_(false) {
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(Task task) {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            Task task;
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                cv_.wait(lock, [this] {
+                    return stop_ || !tasks_.empty();
+                });
+
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<Task> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// ─── Chase-Lev work-stealing deque ───────────────────────────────────────────
+//
+// Single owner: push() and pop() may only be called by the owning worker.
+// Any thread may call steal(). Elements are raw pointers so that every slot
+// fits in a lock-free std::atomic.
+
+template <typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(std::int64_t capacity = 1024)
+        : top_(0), bottom_(0), array_(new Array(capacity)) {
+        retired_.emplace_back(array_.load(std::memory_order_relaxed));
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only.
+    void push(T* item) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only. Returns nullptr when empty or when a thief won the race
+    // for the last element.
+    T* pop() {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = a->get(b);
+        if (t == b) {
+            // Last element: race against thieves for it.
+            if (!top_.compare_exchange_strong(t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread. Returns nullptr when empty or when the CAS lost a race.
+    T* steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+
+        if (t >= b) return nullptr;
+
+        Array* a = array_.load(std::memory_order_acquire);
+        T* item = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+private:
+    struct Array {
+        explicit Array(std::int64_t cap)
+            : capacity(cap), mask(cap - 1), slots(new std::atomic<T*>[cap]) {}
+
+        T* get(std::int64_t i) const {
+            return slots[i & mask].load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, T* item) {
+            slots[i & mask].store(item, std::memory_order_relaxed);
+        }
+
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    // Old arrays may still be read by in-flight thieves, so they are kept
+    // alive until the deque is destroyed instead of being freed immediately.
+    Array* grow(Array* old, std::int64_t t, std::int64_t b) {
+        auto bigger = std::make_unique<Array>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        Array* raw = bigger.get();
+        retired_.push_back(std::move(bigger));
+        array_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_;
+    alignas(64) std::atomic<std::int64_t> bottom_;
+    std::atomic<Array*> array_;
+    std::vector<std::unique_ptr<Array>> retired_;
+};
+
+// ─── Work-stealing pool ──────────────────────────────────────────────────────
+
+class WorkStealingThreadPool {
+public:
+    explicit WorkStealingThreadPool(size_t num_threads) {
+        queues_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            queues_.push_back(std::make_unique<ChaseLevDeque<Task>>());
+        }
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&WorkStealingThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~WorkStealingThreadPool() {
+        {
+            std::scoped_lock lock(sleep_mutex_);
+            stop_.store(true);
+        }
+        sleep_cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    // Called from a worker of this pool: push onto its own deque (no lock).
+    // Called from anywhere else: push onto the shared injection queue.
+    void enqueue(Task task) {
+        auto* item = new Task(std::move(task));
+        if (tls_pool_ == this) {
+            queues_[tls_index_]->push(item);
+        } else {
+            std::scoped_lock lock(inject_mutex_);
+            inject_.push_back(item);
+        }
+        pending_.fetch_add(1);
+
+        // Only pay for the condvar when someone is actually asleep.
+        if (sleepers_.load() > 0) {
+            { std::scoped_lock lock(sleep_mutex_); }
+            sleep_cv_.notify_one();
+        }
+    }
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    Task* take_from_injection() {
+        std::scoped_lock lock(inject_mutex_);
+        if (inject_.empty()) return nullptr;
+        Task* item = inject_.front();
+        inject_.pop_front();
+        return item;
+    }
+
+    Task* steal_from_victims(size_t self, std::uint64_t& rng) {
+        size_t n = queues_.size();
+        if (n <= 1) return nullptr;
+        // xorshift64: cheap per-worker random victim selection
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        size_t start = static_cast<size_t>(rng % n);
+        for (size_t k = 0; k < n; ++k) {
+            size_t victim = (start + k) % n;
+            if (victim == self) continue;
+            if (Task* item = queues_[victim]->steal()) return item;
+        }
+        return nullptr;
+    }
+
+    Task* find_task(size_t self, std::uint64_t& rng) {
+        if (Task* item = queues_[self]->pop()) return item;
+        if (Task* item = take_from_injection()) return item;
+        return steal_from_victims(self, rng);
+    }
+
+    void worker_loop(size_t index) {
+        tls_pool_ = this;
+        tls_index_ = index;
+        std::uint64_t rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+
+        while (true) {
+            if (Task* item = find_task(index, rng)) {
+                pending_.fetch_sub(1);
+                (*item)();
+                delete item;
+                continue;
+            }
+
+            // pending_ > 0 but nothing found: a push is mid-flight or a
+            // steal lost a CAS race. Retry instead of sleeping.
+            if (pending_.load() > 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleepers_.fetch_add(1);
+            sleep_cv_.wait(lock, [this] {
+                return stop_.load() || pending_.load() > 0;
+            });
+            sleepers_.fetch_sub(1);
+            if (stop_.load() && pending_.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    static thread_local WorkStealingThreadPool* tls_pool_;
+    static thread_local size_t tls_index_;
+
+    std::vector<std::unique_ptr<ChaseLevDeque<Task>>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex inject_mutex_;
+    std::deque<Task*> inject_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<long> pending_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> stop_{false};
+};
+
+thread_local WorkStealingThreadPool* WorkStealingThreadPool::tls_pool_ = nullptr;
+thread_local size_t WorkStealingThreadPool::tls_index_ = 0;
+
+// ─── Benchmark ───────────────────────────────────────────────────────────────
+
+// Busy-wait instead of sleeping: sleep_for cannot resolve 100 ns.
+void spin_for(std::chrono::nanoseconds d) {
+    auto end = std::chrono::steady_clock::now() + d;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+// Each root task fans out `children` child tasks from inside the pool.
+template <typename Pool>
+double run_ms(size_t threads, std::chrono::nanoseconds work,
+              long roots, long children) {
+    std::atomic<long> done{0};
+    const long total = roots * (children + 1);
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        Pool pool(threads);
+        for (long r = 0; r < roots; ++r) {
+            pool.enqueue([&pool, &done, work, children] {
+                for (long c = 0; c < children; ++c) {
+                    pool.enqueue([&done, work] {
+                        spin_for(work);
+                        done.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+                spin_for(work);
+                done.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        while (done.load(std::memory_order_relaxed) < total) {
+            std::this_thread::yield();
+        }
+    }
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main() {
+    unsigned int hw = std::thread::hardware_concurrency();
+    if (hw == 0) hw = 2;  // Default to 2 if unknown
+
+    std::vector<size_t> thread_counts;
+    for (size_t t = 1; t < hw; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(hw);
+
+    const std::chrono::nanoseconds durations[] = {
+        std::chrono::nanoseconds(100),
+        std::chrono::microseconds(1),
+        std::chrono::microseconds(10),
+    };
+
+    constexpr long kRoots = 64;
+    constexpr long kChildren = 1000;
+
+    std::cout << "Tasks per run: " << kRoots * (kChildren + 1) << "\n\n";
+    std::cout << std::setw(8) << "task" << std::setw(9) << "threads"
+              << std::setw(16) << "single (ms)" << std::setw(16) << "stealing (ms)"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (auto work : durations) {
+        // Keep each run well under a few seconds even on small machines.
+        long children = work >= std::chrono::microseconds(10) ? kChildren / 10 : kChildren;
+        for (size_t threads : thread_counts) {
+            double single = run_ms<ThreadPool>(threads, work, kRoots, children);
+            double steal  = run_ms<WorkStealingThreadPool>(threads, work, kRoots, children);
+            std::cout << std::setw(6) << work.count() << "ns"
+                      << std::setw(9) << threads
+                      << std::setw(16) << std::fixed << std::setprecision(2) << single
+                      << std::setw(16) << steal
+                      << std::setw(9) << single / steal << "x\n";
+        }
+    }
+
+    std::cout << "\nNote: the gap grows with thread count and shrinks with task\n"
+              << "length. For 10 us tasks the shared lock is rarely contended,\n"
+              << "so both pools perform about the same.\n";
+    return 0;
+}